@@ -2,605 +2,4118 @@
 Program 2: Food Web Analysis with Dynamic Memory
 Course: CS 211, Fall 2024, UIC
 Author: Yousuf Hussain
+Build: gcc -O2 -pthread main.c -o foodweb
+Besides the commands in its menu, which is printed exactly as it always was, the
+modification loop also accepts:
+  k = knockout sweep (rank species by secondary extinctions)
+  a <consumer> <organism> = dependency query (does the consumer depend on the organism,
+      and by which shortest food chain)
 -------------------------------------------*/
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
-// Struct to represent an organism and its prey in the food web
+// Struct to represent an organism and its prey in the food web.
+// Organisms live in stable slots: prey and pred hold slot numbers, which never shift when
+// another organism goes extinct. The index the user sees is the organism's rank among the
+// organisms that are not extinct.
 typedef struct Org_struct {
-    char name[20]; //// Name of the organism
-    int* prey; // Dynamic array of indices  
+    const char* name; // Name of the organism, interned in the web's name arena
+    unsigned int nameHash; // Hash of the name, kept so the name table can be rebuilt cheaply
+    int* prey; // Dynamic array of slots, a block of the web's list arena  
+    float* preyWeight; // Weighted webs only: weight of each relation, parallel to prey (else NULL)
     int numPrey; // Number of prey this organism has
+    int preyCap; // Number of prey the prey array can hold before it must grow (-1: in a snapshot)
+    int* pred; // Dynamic array of the slots of organisms that eat this one (any order)
+    int numPred; // Number of predators that eat this organism, kept up to date on every change
+    int predCap; // Number of predators the pred array can hold before it must grow (-1: in a snapshot)
+    bool extinct; // Tombstone: the slot stays in place until the web is compacted
+    int numBasalPrey; // Cached: number of prey that are producers (used for vore types)
+    int height; // Cached: height in the food web, valid while the web's heightsValid is set
+    int cycle; // Cached: id of the strongly connected component, valid with height
 } Org;
 
-// Adds a new organism to the food web
-void addOrgToWeb(Org** ppWeb, int* pNumOrg, char* newOrgName) {
-    if (*pNumOrg == 0) {
-        *ppWeb = (Org*)malloc(sizeof(Org)); // Allocate memory for the first organism
+// Struct to represent one block of the name arena; names are packed back to back and
+// never move, so an organism's name pointer stays valid for the life of the web
+typedef struct NameChunk_struct {
+    struct NameChunk_struct* next; // Previously filled chunk
+    size_t used; // Bytes of data handed out
+    size_t cap; // Bytes of data available
+    char data[]; // The packed, NUL-terminated names
+} NameChunk;
+
+#define NUM_LIST_CLASSES 30 // Size classes of relation list blocks: 4, 8, 16, ... ints
+
+// Struct to represent one block of the list arena, which holds every prey and predator list
+// of the web. Blocks are carved off the end of the newest chunk; a freed block goes on the
+// free list of its size class and is handed out again before any new memory.
+typedef struct ListChunk_struct {
+    struct ListChunk_struct* next; // Previously allocated chunk
+    size_t used; // Ints of data handed out
+    size_t cap; // Ints of data available
+    int data[]; // The blocks
+} ListChunk;
+
+// Struct to represent the whole food web as a growable array of organism slots.
+// Besides the organisms it keeps the analysis results that the mutation functions patch
+// as they go, so displaying the web only recomputes what an edit actually invalidated.
+typedef struct Web_struct {
+    Org* orgs; // Dynamic array of organism slots, extinct ones included
+    int numSlots; // Number of slots in use
+    int capOrg; // Number of slots the array can hold before it must grow
+    int numOrg; // Number of organisms in the web (slots that are not extinct)
+    int* liveTree; // Fenwick tree over the slots counting live organisms, capOrg + 1 entries
+    int* preyDegCount; // preyDegCount[d] = number of organisms that eat exactly d prey
+    int maxPrey; // Largest number of prey any organism eats
+    int* predDegCount; // predDegCount[d] = number of organisms eaten by exactly d predators
+    int maxPred; // Largest number of predators any organism has
+    bool heightsValid; // The cached heights and cycle ids are up to date
+    bool hasCycles; // The cached heights contain at least one feeding cycle
+    int numCycleIds; // Cycle ids handed out so far (all less than this)
+    unsigned char* tags; // Classification of each slot (TAG_* bits), capOrg entries
+    unsigned char* raiseQueued; // Height repair scratch: 1 while a slot waits in raiseHeights' queue, capOrg entries
+    int* slotPrey; // numPrey of each slot, copied into a flat array (capOrg entries) for classification
+    int* slotBasal; // numBasalPrey of each slot, likewise
+    int* slotPred; // numPred of each slot, likewise
+    unsigned char* slotLive; // 1 for a live slot, 0 for a tombstone, likewise
+    bool tagsValid; // The tags are up to date
+    bool weighted; // Relations carry weights and the trophic levels are computed (weighted mode)
+    double* levels; // Flow-weighted trophic level of each slot (-1 if undefined), numSlots entries
+    bool levelsValid; // The trophic levels are up to date
+    int* reachComp; // Reachability index: feeding-cycle component of each slot (-1 if extinct), numSlots entries
+    int* reachLow; // Lowest component each component depends on, directly or not
+    int* reachHeight; // Height of each component (a component only depends on lower ones)
+    unsigned long long* reachBits; // Row c has bit d set if component c depends on component d, or NULL if too big
+    int reachWords; // 64-bit words per row of reachBits
+    int* reachParent; // Search scratch: one more than the slot that reached each slot, all 0 between searches
+    int* reachQueue; // Search scratch: slots in the order the search reached them
+    bool reachValid; // The reachability index is up to date
+    NameChunk* nameArena; // Chunk that new names are copied into
+    ListChunk* listArena; // Chunk that new relation list blocks are carved from
+    int* listFree[NUM_LIST_CLASSES]; // Free blocks of each size class, linked through their first bytes
+    int* nameTable; // Open-addressing hash table of live slots keyed by name
+    int nameTableCap; // Number of buckets (a power of two, or 0 before the first name)
+    int nameTableUsed; // Buckets holding a slot or a deletion marker
+    int numRel; // Number of predator/prey relations in the web
+    int numPending; // Extinctions whose relations applyPending has yet to unlink (batch mode)
+    unsigned long long* preyBits; // Dense webs only: bit (pred, prey) of a capOrg x capOrg matrix, else NULL
+    int bitWords; // 64-bit words per row of preyBits
+    char* snapshot; // Mapped snapshot file the web was loaded from (NULL if none)
+    size_t snapshotLen; // Length of the mapping
+} Web;
+
+#define NAME_EMPTY -1 // Name table bucket that ends a probe sequence
+#define NAME_DELETED -2 // Name table bucket whose organism went extinct
+#define MAX_NAME_LEN 255 // Longest organism name read from the input
+#define STR(x) #x
+#define XSTR(x) STR(x)
+#define NUM_SECTIONS 8 // Sections printed by displayAll (the trophic levels only for a weighted web)
+
+// Phases timed in timing mode; the displayAll sections follow the fixed phases
+#define PHASE_NAMES 0 // Reading the organisms of the initial web
+#define PHASE_RELATIONS 1 // Reading the relations of the initial web
+#define PHASE_SNAPSHOT 2 // Loading or saving a snapshot
+#define PHASE_MODIFICATIONS 3 // The whole modification loop
+#define PHASE_HEIGHTS 4 // Bringing the cached heights up to date
+#define PHASE_CLASSIFY 5 // Tagging the organisms for the classification sections
+#define PHASE_LEVELS 6 // Solving the trophic levels of a weighted web
+#define PHASE_JOURNAL 7 // Recovering from the journal and writing its checkpoints
+#define PHASE_REACH 8 // Building the reachability index for dependency queries
+#define PHASE_SECTION 9 // First displayAll section
+#define NUM_PHASES (PHASE_SECTION + NUM_SECTIONS)
+
+// Struct to represent the instrumentation of a run. The counters are only kept and the clock is
+// only read in timing mode (-t); everything is reported at exit in that mode.
+typedef struct Stats_struct {
+    bool timing; // Timing mode: the phase timers run and the summary is printed
+    double seconds[NUM_PHASES]; // Time spent in each phase
+    long long calls[NUM_PHASES]; // Times each phase ran
+    long long allocations; // Blocks the web code allocated or grew
+    long long bytesCopied; // Bytes moved by array growth, list shifts, names and compaction
+    long long edgesScanned; // Relation entries examined by edits and analysis passes
+} Stats;
+
+Stats stats; // Counters of the whole run (all zero at start)
+
+// Adds to a counter in timing mode; relaxed atomics keep the counts exact when pool threads
+// count too, and without timing mode the edit and load paths only pay for the flag test
+void countStat(long long* pCounter, long long amount) {
+    if (stats.timing) {
+        __atomic_fetch_add(pCounter, amount, __ATOMIC_RELAXED);
     }
+}
 
-    else {
-        Org *webCpy = (Org*)malloc(sizeof(Org)*(*(pNumOrg) + 1)); // Allocate memory for an additional organism
-        
-        // Copy existing organisms to the new array
-        for (int i = 0; i < *pNumOrg; i++) {
-            webCpy[i] = (*ppWeb)[i]; 
+// Returns the time in seconds on a monotonic clock
+double readClock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Returns the start time of a phase, or 0 without reading the clock when timing is off
+double startPhase() {
+    if (!stats.timing) {
+        return 0.0;
+    }
+    return readClock();
+}
+
+// Charges the time since start to a phase (each phase is only ever timed by one thread at once)
+void endPhase(int phase, double start) {
+    if (!stats.timing) {
+        return;
+    }
+    stats.seconds[phase] += startPhase() - start;
+    (stats.calls[phase])++;
+}
+
+// Returns the capacity to grow to so that repeated appends cost amortized O(1)
+int growCapacity(int cap) {
+    return (cap < 4) ? 4 : cap * 2;
+}
+
+// Appends a value to a growable int array
+void appendInt(int** pArr, int* pNum, int* pCap, int value) {
+    if (*pNum == *pCap) {
+        *pCap = growCapacity(*pCap);
+        *pArr = (int*)realloc(*pArr, sizeof(int) * (*pCap));
+        countStat(&(stats.allocations), 1);
+        countStat(&(stats.bytesCopied), sizeof(int) * (*pNum));
+    }
+    (*pArr)[(*pNum)++] = value;
+}
+
+#define LIST_CHUNK_INTS 65536 // Ints per chunk of the list arena
+
+// Returns the size class of a block that holds cap ints (4 << class >= cap)
+int listClass(int cap) {
+    int c = 0;
+    while ((4 << c) < cap) {
+        c++;
+    }
+    return c;
+}
+
+// Hands out a block of 4 << listClass(cap) ints from the web's list arena
+int* allocList(Web* pWeb, int cap) {
+    int c = listClass(cap);
+    int* block = pWeb->listFree[c];
+    if (block != NULL) { // Reuse a freed block; it holds the next free one
+        memcpy(&(pWeb->listFree[c]), block, sizeof(int*));
+        return block;
+    }
+    size_t size = (size_t)4 << c;
+    ListChunk* chunk = pWeb->listArena;
+    if (chunk == NULL || chunk->cap - chunk->used < size) {
+        // A block too big to share a chunk gets one of its own, behind the chunk being filled
+        size_t capInts = (size > LIST_CHUNK_INTS / 4) ? size : LIST_CHUNK_INTS;
+        ListChunk* fresh = (ListChunk*)malloc(sizeof(ListChunk) + sizeof(int) * capInts);
+        countStat(&(stats.allocations), 1);
+        fresh->cap = capInts;
+        if (capInts == size && chunk != NULL) {
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+            fresh->used = size;
+            return fresh->data;
+        }
+        fresh->next = chunk;
+        fresh->used = 0;
+        pWeb->listArena = chunk = fresh;
+    }
+    block = chunk->data + chunk->used;
+    chunk->used += size;
+    return block;
+}
+
+// Returns a block to the free list of its size class
+void freeList(Web* pWeb, int* list, int cap) {
+    int c = listClass(cap);
+    memcpy(list, &(pWeb->listFree[c]), sizeof(int*));
+    pWeb->listFree[c] = list;
+}
+
+// Moves a list of num ints to a block of newCap ints. A list still in a mapped snapshot
+// (capacity -1) is copied out and left where it is.
+void moveList(Web* pWeb, int** pList, int num, int* pCap, int newCap) {
+    int* moved = allocList(pWeb, newCap);
+    if (num > 0) {
+        memcpy(moved, *pList, sizeof(int) * num);
+    }
+    countStat(&(stats.bytesCopied), sizeof(int) * num);
+    if (*pCap > 0) {
+        freeList(pWeb, *pList, *pCap);
+    }
+    *pList = moved;
+    *pCap = 4 << listClass(newCap);
+}
+
+// Appends a value to a relation list of the web, moving it up a size class when it is full
+void appendToList(Web* pWeb, int** pList, int* pNum, int* pCap, int value) {
+    if (*pNum >= *pCap) {
+        moveList(pWeb, pList, *pNum, pCap, *pNum + 1);
+    }
+    (*pList)[(*pNum)++] = value;
+}
+
+// Moves a relation list down a size class once it is a quarter full, so lists that shrink
+// give their memory back to the free lists
+void shrinkList(Web* pWeb, int** pList, int num, int* pCap) {
+    if (*pCap > 4 && num <= *pCap / 4) {
+        moveList(pWeb, pList, num, pCap, *pCap / 2);
+    }
+}
+
+// On a weighted web every prey list has a weight list of the same capacity beside it, so the
+// prey lists are grown, shrunk and freed through the helpers below, which keep the two in step.
+
+// Moves the prey list of an organism (and its weights) to a block of newCap entries
+void resizePrey(Web* pWeb, Org* pOrg, int newCap) {
+    if (pWeb->weighted) {
+        int* weights = (int*)pOrg->preyWeight; // A float block is an int block of the same size
+        int cap = pOrg->preyCap;
+        moveList(pWeb, &weights, pOrg->numPrey, &cap, newCap);
+        pOrg->preyWeight = (float*)weights;
+    }
+    moveList(pWeb, &(pOrg->prey), pOrg->numPrey, &(pOrg->preyCap), newCap);
+}
+
+// Appends a prey slot and its weight, moving both lists up a size class when they are full
+void appendPrey(Web* pWeb, Org* pOrg, int preySlot, float weight) {
+    if (pOrg->numPrey >= pOrg->preyCap) {
+        resizePrey(pWeb, pOrg, pOrg->numPrey + 1);
+    }
+    if (pWeb->weighted) {
+        pOrg->preyWeight[pOrg->numPrey] = weight;
+    }
+    pOrg->prey[(pOrg->numPrey)++] = preySlot;
+}
+
+// Moves the prey lists down a size class once they are a quarter full (see shrinkList)
+void shrinkPrey(Web* pWeb, Org* pOrg) {
+    if (pOrg->preyCap > 4 && pOrg->numPrey <= pOrg->preyCap / 4) {
+        resizePrey(pWeb, pOrg, pOrg->preyCap / 2);
+    }
+}
+
+// Frees the prey lists of an organism and leaves it with no prey
+void freePrey(Web* pWeb, Org* pOrg) {
+    if (pOrg->preyCap > 0) {
+        freeList(pWeb, pOrg->prey, pOrg->preyCap);
+        if (pWeb->weighted) {
+            freeList(pWeb, (int*)pOrg->preyWeight, pOrg->preyCap);
+        }
+    }
+    pOrg->prey = NULL;
+    pOrg->preyWeight = NULL;
+    pOrg->numPrey = pOrg->preyCap = 0;
+}
+
+// Struct to represent an output buffer. Everything the program prints is formatted into a
+// large reusable buffer and handed to the sink in big writes instead of one stdio call per
+// name. A buffer with no sink only collects text, to be appended to another buffer later.
+typedef struct OutBuf_struct {
+    char* data; // Text not yet written
+    size_t len; // Number of bytes in data
+    size_t cap; // Bytes data can hold before it must grow
+    FILE* sink; // Where flushOut writes, or NULL for a memory-only buffer
+} OutBuf;
+
+#define OUT_FLUSH_SIZE (1 << 20) // Buffered bytes that trigger a write to the sink
+
+// Initializes an empty output buffer
+void initOut(OutBuf* pOut, FILE* sink) {
+    pOut->data = NULL;
+    pOut->len = 0;
+    pOut->cap = 0;
+    pOut->sink = sink;
+}
+
+// Writes the buffered text to the sink and empties the buffer
+void flushOut(OutBuf* pOut) {
+    if (pOut->sink != NULL && pOut->len > 0) {
+        fwrite(pOut->data, 1, pOut->len, pOut->sink);
+        fflush(pOut->sink);
+        pOut->len = 0;
+    }
+}
+
+// Makes room for extra more bytes (plus a terminating NUL)
+void reserveOut(OutBuf* pOut, size_t extra) {
+    if (pOut->len + extra + 1 > pOut->cap) {
+        size_t cap = (pOut->cap < 4096) ? 4096 : pOut->cap;
+        while (pOut->len + extra + 1 > cap) {
+            cap *= 2;
+        }
+        pOut->data = (char*)realloc(pOut->data, cap);
+        pOut->cap = cap;
+    }
+}
+
+// Appends len bytes; a NULL buffer discards the text
+void outBytes(OutBuf* pOut, const char* bytes, size_t len) {
+    if (pOut == NULL || len == 0) {
+        return;
+    }
+    reserveOut(pOut, len);
+    memcpy(pOut->data + pOut->len, bytes, len);
+    pOut->len += len;
+    if (pOut->len >= OUT_FLUSH_SIZE) {
+        flushOut(pOut);
+    }
+}
+
+// Appends a string
+void outStr(OutBuf* pOut, const char* str) {
+    outBytes(pOut, str, strlen(str));
+}
+
+// Appends printf-style formatted text
+void outPrintf(OutBuf* pOut, const char* format, ...) {
+    if (pOut == NULL) {
+        return;
+    }
+    reserveOut(pOut, 64);
+    va_list args;
+    va_start(args, format);
+    int need = vsnprintf(pOut->data + pOut->len, pOut->cap - pOut->len, format, args);
+    va_end(args);
+    if (pOut->len + need + 1 > pOut->cap) { // It did not fit: grow and format again
+        reserveOut(pOut, need);
+        va_start(args, format);
+        vsnprintf(pOut->data + pOut->len, pOut->cap - pOut->len, format, args);
+        va_end(args);
+    }
+    pOut->len += need;
+    if (pOut->len >= OUT_FLUSH_SIZE) {
+        flushOut(pOut);
+    }
+}
+
+// Writes out anything left and frees the buffer
+void freeOut(OutBuf* pOut) {
+    flushOut(pOut);
+    free(pOut->data);
+    initOut(pOut, pOut->sink);
+}
+
+// Copies the fields classification reads from a slot's Org into the web's flat arrays; every
+// edit that changes a slot's prey, predators or extinction calls it for that slot
+void syncSlot(Web* pWeb, int slot) {
+    const Org* pOrg = &(pWeb->orgs[slot]);
+    pWeb->slotPrey[slot] = pOrg->numPrey;
+    pWeb->slotBasal[slot] = pOrg->numBasalPrey;
+    pWeb->slotPred[slot] = pOrg->numPred;
+    pWeb->slotLive[slot] = !pOrg->extinct;
+}
+
+// Sizes the flat classification arrays for capOrg slots
+void resizeSlotArrays(Web* pWeb) {
+    pWeb->slotPrey = (int*)realloc(pWeb->slotPrey, sizeof(int) * pWeb->capOrg);
+    pWeb->slotBasal = (int*)realloc(pWeb->slotBasal, sizeof(int) * pWeb->capOrg);
+    pWeb->slotPred = (int*)realloc(pWeb->slotPred, sizeof(int) * pWeb->capOrg);
+    pWeb->slotLive = (unsigned char*)realloc(pWeb->slotLive, pWeb->capOrg);
+}
+
+// Initializes an empty food web
+void initWeb(Web* pWeb) {
+    pWeb->orgs = NULL; // Nothing is allocated until the first organism is added
+    pWeb->numSlots = 0;
+    pWeb->capOrg = 0;
+    pWeb->numOrg = 0;
+    pWeb->liveTree = NULL;
+    pWeb->preyDegCount = NULL;
+    pWeb->maxPrey = 0;
+    pWeb->predDegCount = NULL;
+    pWeb->maxPred = 0;
+    pWeb->heightsValid = true; // An empty web trivially has all its heights
+    pWeb->hasCycles = false;
+    pWeb->numCycleIds = 0;
+    pWeb->tags = NULL;
+    pWeb->raiseQueued = NULL;
+    pWeb->slotPrey = NULL;
+    pWeb->slotBasal = NULL;
+    pWeb->slotPred = NULL;
+    pWeb->slotLive = NULL;
+    pWeb->tagsValid = false;
+    pWeb->weighted = false;
+    pWeb->levels = NULL;
+    pWeb->levelsValid = false;
+    pWeb->reachComp = NULL;
+    pWeb->reachLow = NULL;
+    pWeb->reachHeight = NULL;
+    pWeb->reachBits = NULL;
+    pWeb->reachWords = 0;
+    pWeb->reachParent = NULL;
+    pWeb->reachQueue = NULL;
+    pWeb->reachValid = false;
+    pWeb->nameArena = NULL;
+    pWeb->listArena = NULL;
+    for (int c = 0; c < NUM_LIST_CLASSES; c++) {
+        pWeb->listFree[c] = NULL;
+    }
+    pWeb->nameTable = NULL;
+    pWeb->nameTableCap = 0;
+    pWeb->nameTableUsed = 0;
+    pWeb->numRel = 0;
+    pWeb->numPending = 0;
+    pWeb->preyBits = NULL;
+    pWeb->bitWords = 0;
+    pWeb->snapshot = NULL;
+    pWeb->snapshotLen = 0;
+}
+
+// Returns the FNV-1a hash of a name
+unsigned int hashName(const char* name) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)name; *c != '\0'; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+// Copies a name into the arena and returns its permanent address
+const char* storeName(Web* pWeb, const char* name) {
+    size_t len = strlen(name) + 1;
+    NameChunk* chunk = pWeb->nameArena;
+    if (chunk == NULL || chunk->cap - chunk->used < len) {
+        size_t cap = (len > 65536) ? len : 65536;
+        NameChunk* fresh = (NameChunk*)malloc(sizeof(NameChunk) + cap);
+        fresh->next = chunk;
+        fresh->used = 0;
+        fresh->cap = cap;
+        pWeb->nameArena = chunk = fresh;
+        countStat(&(stats.allocations), 1);
+    }
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, name, len);
+    countStat(&(stats.bytesCopied), len);
+    chunk->used += len;
+    return copy;
+}
+
+// Returns the lowest live slot with this name, or -1; O(1) expected
+int slotOfName(const Web* pWeb, const char* name, unsigned int hash) {
+    int best = -1;
+    if (pWeb->nameTableCap == 0) {
+        return best;
+    }
+    int mask = pWeb->nameTableCap - 1;
+    // Duplicate names share a probe sequence, so keep going to find the lowest slot
+    for (int b = hash & mask; pWeb->nameTable[b] != NAME_EMPTY; b = (b + 1) & mask) {
+        int slot = pWeb->nameTable[b];
+        if (slot >= 0 && pWeb->orgs[slot].nameHash == hash && strcmp(pWeb->orgs[slot].name, name) == 0) {
+            if (best == -1 || slot < best) {
+                best = slot;
+            }
+        }
+    }
+    return best;
+}
+
+// Puts a slot into the name table, growing it to keep the load factor under 1/2
+void insertName(Web* pWeb, int slot) {
+    if (2 * (pWeb->nameTableUsed + 1) > pWeb->nameTableCap) {
+        // Rebuild from the live organisms, which also clears out the deletion markers
+        int cap = 16;
+        while (cap < 4 * (pWeb->numOrg + 1)) {
+            cap *= 2;
+        }
+        free(pWeb->nameTable);
+        pWeb->nameTable = (int*)malloc(sizeof(int) * cap);
+        for (int b = 0; b < cap; b++) {
+            pWeb->nameTable[b] = NAME_EMPTY;
+        }
+        pWeb->nameTableCap = cap;
+        pWeb->nameTableUsed = 0;
+        for (int s = 0; s < pWeb->numSlots; s++) {
+            if (s != slot && !pWeb->orgs[s].extinct) {
+                insertName(pWeb, s);
+            }
+        }
+    }
+    int mask = pWeb->nameTableCap - 1;
+    int b = pWeb->orgs[slot].nameHash & mask;
+    while (pWeb->nameTable[b] != NAME_EMPTY) {
+        b = (b + 1) & mask;
+    }
+    pWeb->nameTable[b] = slot;
+    (pWeb->nameTableUsed)++;
+}
+
+// Takes an extinct slot out of the name table
+void eraseName(Web* pWeb, int slot) {
+    int mask = pWeb->nameTableCap - 1;
+    for (int b = pWeb->orgs[slot].nameHash & mask; pWeb->nameTable[b] != NAME_EMPTY; b = (b + 1) & mask) {
+        if (pWeb->nameTable[b] == slot) {
+            pWeb->nameTable[b] = NAME_DELETED;
+            return;
+        }
+    }
+}
+
+// Rebuilds the name table after the slots were renumbered
+void rebuildNameTable(Web* pWeb) {
+    for (int b = 0; b < pWeb->nameTableCap; b++) {
+        pWeb->nameTable[b] = NAME_EMPTY;
+    }
+    pWeb->nameTableUsed = 0;
+    for (int s = 0; s < pWeb->numSlots; s++) {
+        insertName(pWeb, s); // Compaction leaves only live slots
+    }
+}
+
+// Moves an organism from one bucket of a degree histogram to another, keeping the maximum
+void moveDegree(int* degCount, int* pMax, int from, int to) {
+    if (from >= 0) {
+        degCount[from]--;
+    }
+    if (to >= 0) {
+        degCount[to]++;
+        if (to > *pMax) {
+            *pMax = to;
+        }
+    }
+    // The maximum only drops when its bucket empties; each step down is paid by an edge removal
+    while (*pMax > 0 && degCount[*pMax] == 0) {
+        (*pMax)--;
+    }
+}
+
+// Pushes a slot onto a binary min-heap ordered by key; each entry packs the key above the slot
+void pushHeap(long long** pHeap, int* pNum, int* pCap, int key, int slot) {
+    if (*pNum == *pCap) {
+        *pCap = growCapacity(*pCap);
+        *pHeap = (long long*)realloc(*pHeap, sizeof(long long) * (*pCap));
+        countStat(&(stats.allocations), 1);
+        countStat(&(stats.bytesCopied), sizeof(long long) * (*pNum));
+    }
+    long long* heap = *pHeap;
+    long long entry = ((long long)key << 32) | (unsigned int)slot;
+    int i = (*pNum)++;
+    while (i > 0 && heap[(i - 1) / 2] > entry) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+}
+
+// Removes the entry with the smallest key from a heap built by pushHeap and returns its slot
+int popHeap(long long* heap, int* pNum) {
+    int slot = (int)(heap[0] & 0xFFFFFFFF);
+    long long last = heap[--(*pNum)];
+    int i = 0;
+    while (2 * i + 1 < *pNum) {
+        int child = 2 * i + 1;
+        if (child + 1 < *pNum && heap[child + 1] < heap[child]) {
+            child++;
+        }
+        if (heap[child] >= last) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return slot;
+}
+
+// Raises heights above a new relation pred -> prey. In an acyclic web only the organisms that
+// (transitively) eat the predator can change. If the raise reaches the prey, the relation
+// closed a feeding cycle and the heights are left for a full recompute instead.
+// The raised organisms are visited in order of their height before the edit. Those heights
+// order the web topologically, so an organism is only visited once all the prey it eats have
+// their final heights, and each one is scanned once: the repair is O(affected edges * log).
+void raiseHeights(Web* pWeb, int predSlot, int preySlot) {
+    Org* orgs = pWeb->orgs;
+    if (orgs[preySlot].height + 1 <= orgs[predSlot].height) {
+        return; // The prey sits lower, so nothing changes and no cycle can have formed
+    }
+    unsigned char* queued = pWeb->raiseQueued;
+    long long* heap = NULL;
+    int numHeap = 0;
+    int heapCap = 0;
+    pushHeap(&heap, &numHeap, &heapCap, orgs[predSlot].height, predSlot);
+    queued[predSlot] = 1;
+    orgs[predSlot].height = orgs[preySlot].height + 1;
+    while (numHeap > 0) {
+        int slot = popHeap(heap, &numHeap);
+        queued[slot] = 0;
+        Org* pOrg = &(orgs[slot]);
+        countStat(&(stats.edgesScanned), pOrg->numPred);
+        for (int j = 0; j < pOrg->numPred; j++) {
+            int eater = pOrg->pred[j];
+            Org* pEater = &(orgs[eater]);
+            if (pEater->height >= pOrg->height + 1) {
+                continue;
+            }
+            if (eater == preySlot) {
+                pWeb->heightsValid = false;
+                for (int k = 0; k < numHeap; k++) {
+                    queued[heap[k] & 0xFFFFFFFF] = 0; // Leave the scratch clear for the next repair
+                }
+                free(heap);
+                return;
+            }
+            if (!queued[eater]) {
+                pushHeap(&heap, &numHeap, &heapCap, pEater->height, eater); // Keyed by its height before the raise
+                queued[eater] = 1;
+            }
+            pEater->height = pOrg->height + 1;
+        }
+    }
+    free(heap);
+}
+
+// Rebuilds the Fenwick tree of live slots in O(capOrg)
+void rebuildLiveTree(Web* pWeb) {
+    int cap = pWeb->capOrg;
+    for (int i = 1; i <= cap; i++) {
+        pWeb->liveTree[i] = (i <= pWeb->numSlots && !pWeb->orgs[i - 1].extinct) ? 1 : 0;
+    }
+    for (int i = 1; i <= cap; i++) {
+        int parent = i + (i & -i);
+        if (parent <= cap) {
+            pWeb->liveTree[parent] += pWeb->liveTree[i];
+        }
+    }
+}
+
+// Adds delta to the live count of a slot
+void updateLiveTree(Web* pWeb, int slot, int delta) {
+    for (int i = slot + 1; i <= pWeb->capOrg; i += i & -i) {
+        pWeb->liveTree[i] += delta;
+    }
+}
+
+// Returns the slot of the organism at a user-visible index in O(log N), or -1 if out of range
+int slotOfIndex(const Web* pWeb, int index) {
+    if (index < 0 || index >= pWeb->numOrg) {
+        return -1;
+    }
+    int pos = 0;
+    int remaining = index + 1;
+    int step = 1;
+    while (step * 2 <= pWeb->capOrg) {
+        step *= 2;
+    }
+    // Descend the tree to the last position whose prefix count is still below index + 1
+    for (; step > 0; step /= 2) {
+        if (pos + step <= pWeb->capOrg && pWeb->liveTree[pos + step] < remaining) {
+            pos += step;
+            remaining -= pWeb->liveTree[pos];
+        }
+    }
+    return pos;
+}
+
+// Returns the user-visible index of a live slot in O(log N)
+int indexOfSlot(const Web* pWeb, int slot) {
+    int count = 0;
+    for (int i = slot; i > 0; i -= i & -i) { // Live organisms in the slots before this one
+        count += pWeb->liveTree[i];
+    }
+    return count;
+}
+
+// Returns the user-visible index of the organism with this name, or -1 if there is none
+int indexOfName(const Web* pWeb, const char* name) {
+    int slot = slotOfName(pWeb, name, hashName(name));
+    return (slot == -1) ? -1 : indexOfSlot(pWeb, slot);
+}
+
+// Returns the organism at a user-visible index (the index must be valid)
+Org* orgAtIndex(const Web* pWeb, int index) {
+    return &(pWeb->orgs[slotOfIndex(pWeb, index)]);
+}
+
+#define BITSET_MAX_SLOTS 8192 // Largest web (in slots) that may use the adjacency matrix
+
+// Returns true if the web is dense enough for the adjacency matrix: a row of capOrg bits per
+// organism then takes no more memory than its relations do as 32-bit list entries
+bool wantsPreyBits(const Web* pWeb) {
+    return pWeb->capOrg <= BITSET_MAX_SLOTS && (long long)pWeb->numRel * 32 >= (long long)pWeb->capOrg * pWeb->capOrg;
+}
+
+// Returns true if the bit of the relation (predSlot eats preySlot) is set
+bool testPreyBit(const Web* pWeb, int predSlot, int preySlot) {
+    return (pWeb->preyBits[(size_t)predSlot * pWeb->bitWords + (preySlot >> 6)] >> (preySlot & 63)) & 1;
+}
+
+// Sets or clears the bit of the relation (predSlot eats preySlot)
+void setPreyBit(Web* pWeb, int predSlot, int preySlot, bool on) {
+    unsigned long long* word = &(pWeb->preyBits[(size_t)predSlot * pWeb->bitWords + (preySlot >> 6)]);
+    unsigned long long mask = 1ULL << (preySlot & 63);
+    *word = on ? (*word | mask) : (*word & ~mask);
+}
+
+// Rebuilds the adjacency matrix from the prey lists in O(capOrg^2 / 64 + E) when the web
+// is dense enough for it, and drops it otherwise. Called when the slots are resized or
+// renumbered, and when a new relation makes the web dense.
+void rebuildPreyBits(Web* pWeb) {
+    free(pWeb->preyBits);
+    pWeb->preyBits = NULL;
+    pWeb->bitWords = 0;
+    if (!wantsPreyBits(pWeb) || pWeb->capOrg == 0) {
+        return;
+    }
+    pWeb->bitWords = (pWeb->capOrg + 63) / 64;
+    pWeb->preyBits = (unsigned long long*)calloc((size_t)pWeb->capOrg * pWeb->bitWords, sizeof(unsigned long long));
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        const Org* pOrg = &(pWeb->orgs[slot]);
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            setPreyBit(pWeb, slot, pOrg->prey[j], true);
+        }
+    }
+}
+
+// Adds a new organism to the food web
+void addOrgToWeb(Web* pWeb, const char* newOrgName) {
+    // Grow the organism array geometrically only when it is full
+    if (pWeb->numSlots == pWeb->capOrg) {
+        int newCap = growCapacity(pWeb->capOrg);
+        pWeb->orgs = (Org*)realloc(pWeb->orgs, sizeof(Org) * newCap);
+        pWeb->liveTree = (int*)realloc(pWeb->liveTree, sizeof(int) * (newCap + 1));
+        // A degree never reaches the number of slots, so the histograms need newCap buckets
+        pWeb->preyDegCount = (int*)realloc(pWeb->preyDegCount, sizeof(int) * newCap);
+        pWeb->predDegCount = (int*)realloc(pWeb->predDegCount, sizeof(int) * newCap);
+        for (int d = pWeb->capOrg; d < newCap; d++) {
+            pWeb->preyDegCount[d] = 0;
+            pWeb->predDegCount[d] = 0;
+        }
+        pWeb->tags = (unsigned char*)realloc(pWeb->tags, newCap);
+        pWeb->raiseQueued = (unsigned char*)realloc(pWeb->raiseQueued, newCap);
+        countStat(&(stats.allocations), 10);
+        countStat(&(stats.bytesCopied), (sizeof(Org) + 6 * sizeof(int) + 3) * pWeb->capOrg);
+        pWeb->capOrg = newCap;
+        resizeSlotArrays(pWeb);
+        rebuildLiveTree(pWeb);
+        if (pWeb->preyBits != NULL) { // Widen the matrix, or drop it if the web outgrew it
+            rebuildPreyBits(pWeb);
         }
-        free(*ppWeb); // Free old memory and update pointer to new array
-        *ppWeb = webCpy;
     }
 
     // Initialize the new organism
-    strcpy((*ppWeb)[*pNumOrg].name, newOrgName);
-    (*ppWeb)[*pNumOrg].prey = NULL; // No prey yet
-    (*ppWeb)[*pNumOrg].numPrey = 0; // Initial prey count is 0
-    (*pNumOrg)++; // // Increment number of organisms
+    int slot = pWeb->numSlots;
+    Org* pOrg = &(pWeb->orgs[slot]);
+    // Names are stored once: a name already in the web shares the existing copy
+    pOrg->nameHash = hashName(newOrgName);
+    int twin = slotOfName(pWeb, newOrgName, pOrg->nameHash);
+    pOrg->name = (twin == -1) ? storeName(pWeb, newOrgName) : pWeb->orgs[twin].name;
+    pOrg->prey = NULL; // No prey yet
+    pOrg->preyWeight = NULL;
+    pOrg->numPrey = 0; // Initial prey count is 0
+    pOrg->preyCap = 0;
+    pOrg->pred = NULL; // Nothing eats it yet
+    pOrg->numPred = 0;
+    pOrg->predCap = 0;
+    pOrg->extinct = false;
+    pOrg->numBasalPrey = 0;
+    pOrg->height = 0; // A new organism is a producer, in a cycle of its own
+    pOrg->cycle = (pWeb->numCycleIds)++;
+    pWeb->raiseQueued[slot] = 0;
+    (pWeb->numSlots)++;
+    (pWeb->numOrg)++; // Increment number of organisms
+    updateLiveTree(pWeb, slot, 1);
+    moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), -1, 0);
+    moveDegree(pWeb->predDegCount, &(pWeb->maxPred), -1, 0);
+    insertName(pWeb, slot);
+    syncSlot(pWeb, slot);
+    pWeb->tagsValid = false;
+    pWeb->levelsValid = false;
+    pWeb->reachValid = false;
 
     return;
 }
 
-// Adds a predator-prey relationship to the web
-bool addRelationToWeb(Org* pWeb, int numOrg, int predInd, int preyInd) {
+// Adds a predator-prey relationship with a weight (the share of the predator's diet it stands
+// for, relative to its other relations) to the web; problems are reported to pOut (NULL for
+// silence). The weight is only kept on a weighted web.
+bool addWeightedRelationToWeb(Web* pWeb, int predInd, int preyInd, double weight, OutBuf* pOut) {
+    int numOrg = pWeb->numOrg;
     // Ensure valid indices and prevent self-predation
     if (!(predInd >= 0 && preyInd >= 0 && predInd < numOrg &&  preyInd < numOrg && predInd != preyInd)) {
-        printf( "Invalid predator and/or prey index. No relation added to the food web.");
+        outStr(pOut, "Invalid predator and/or prey index. No relation added to the food web.");
         return false;
     }
-    // Check if the relationship already exists
-    for (int i = 0; i < pWeb[predInd].numPrey; i++) {
-        if (((pWeb[predInd]).prey[i]) == preyInd) {
-            printf("Duplicate predator/prey relation. No relation added to the food web.");
-            return false;
+    if (!(weight > 0.0 && weight <= 3.4e38)) { // Also rejects NaN and what a float cannot hold
+        outStr(pOut, "Invalid relation weight. No relation added to the food web.");
+        return false;
+    }
+    int predSlot = slotOfIndex(pWeb, predInd);
+    int preySlot = slotOfIndex(pWeb, preyInd);
+    Org* pPred = &(pWeb->orgs[predSlot]);
+    // Check if the relationship already exists: one bit on a dense web, else a prey list scan
+    bool duplicate = false;
+    if (pWeb->preyBits != NULL) {
+        duplicate = testPreyBit(pWeb, predSlot, preySlot);
+    }
+    else {
+        for (int i = 0; i < pPred->numPrey && !duplicate; i++) {
+            duplicate = (pPred->prey[i] == preySlot);
         }
+        countStat(&(stats.edgesScanned), pPred->numPrey);
+    }
+    if (duplicate) {
+        outStr(pOut, "Duplicate predator/prey relation. No relation added to the food web.");
+        return false;
     }
  
-    // Allocate memory to store the new relationship
-    int *relation = (int*)malloc(sizeof(int)*((pWeb[predInd].numPrey) + 1));
-    for (int i = 0; i < pWeb[predInd].numPrey; i++) {
-        (relation)[i] = (pWeb[predInd].prey)[i]; // Copy old prey array
+    // Patch the cached analysis before the relation lands
+    Org* pPrey = &(pWeb->orgs[preySlot]);
+    moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), pPred->numPrey, pPred->numPrey + 1);
+    moveDegree(pWeb->predDegCount, &(pWeb->maxPred), pPrey->numPred, pPrey->numPred + 1);
+    if (pPrey->numPrey == 0) {
+        (pPred->numBasalPrey)++;
+    }
+    if (pPred->numPrey == 0) { // The predator stops being a producer for everything that eats it
+        for (int j = 0; j < pPred->numPred; j++) {
+            (pWeb->orgs[pPred->pred[j]].numBasalPrey)--;
+            pWeb->slotBasal[pPred->pred[j]]--;
+        }
     }
 
-    free(pWeb[predInd].prey); // Free the old prey array
-    pWeb[predInd].prey = relation; // Assign the new prey array
-    pWeb[predInd].prey[pWeb[predInd].numPrey] = preyInd; // Add the new prey
-    (pWeb[predInd].numPrey)++; // Increment the prey count
+    // Record the relation in both directions; both arrays grow geometrically
+    appendPrey(pWeb, pPred, preySlot, (float)weight);
+    appendToList(pWeb, &(pPrey->pred), &(pPrey->numPred), &(pPrey->predCap), predSlot);
+    (pWeb->numRel)++;
+    syncSlot(pWeb, predSlot);
+    syncSlot(pWeb, preySlot);
+    if (pWeb->preyBits != NULL) {
+        setPreyBit(pWeb, predSlot, preySlot, true);
+    }
+    else if (wantsPreyBits(pWeb)) {
+        rebuildPreyBits(pWeb); // The web just became dense
+    }
+
+    pWeb->tagsValid = false;
+    pWeb->levelsValid = false;
+    pWeb->reachValid = false;
+    if (pWeb->heightsValid && !pWeb->hasCycles) {
+        raiseHeights(pWeb, predSlot, preySlot);
+    }
+    else {
+        pWeb->heightsValid = false;
+    }
 
     return true;    
 }
 
-// Frees the memory allocated for the food web
-void freeWeb(Org* pWeb, int numOrg) {
-    // Free each organism's prey list
-    for (int i = 0; i < numOrg; i++) {
-        free(pWeb[i].prey);
+// Adds a predator-prey relationship of weight 1 to the web; problems are reported to pOut (NULL for silence)
+bool addRelationToWeb(Web* pWeb, int predInd, int preyInd, OutBuf* pOut) {
+    return addWeightedRelationToWeb(pWeb, predInd, preyInd, 1.0, pOut);
+}
+
+// Frees the memory allocated for the food web; the lists go a chunk at a time, not one by one
+void freeWeb(Web* pWeb) {
+    free(pWeb->orgs); // Free the main array holding organisms
+    free(pWeb->liveTree);
+    free(pWeb->preyDegCount);
+    free(pWeb->predDegCount);
+    free(pWeb->tags);
+    free(pWeb->raiseQueued);
+    free(pWeb->slotPrey);
+    free(pWeb->slotBasal);
+    free(pWeb->slotPred);
+    free(pWeb->slotLive);
+    free(pWeb->levels);
+    free(pWeb->reachComp);
+    free(pWeb->reachLow);
+    free(pWeb->reachHeight);
+    free(pWeb->reachBits);
+    free(pWeb->reachParent);
+    free(pWeb->reachQueue);
+    free(pWeb->preyBits);
+    free(pWeb->nameTable);
+    while (pWeb->nameArena != NULL) { // The names go with the arena, a chunk at a time
+        NameChunk* next = pWeb->nameArena->next;
+        free(pWeb->nameArena);
+        pWeb->nameArena = next;
+    }
+    while (pWeb->listArena != NULL) { // Every prey and predator list goes with its chunk
+        ListChunk* next = pWeb->listArena->next;
+        free(pWeb->listArena);
+        pWeb->listArena = next;
+    }
+    if (pWeb->snapshot != NULL) {
+        munmap(pWeb->snapshot, pWeb->snapshotLen);
+    }
+    initWeb(pWeb);
+}
+
+// Drops the extinct slots and renumbers the survivors in one O(N+E) pass.
+// User-visible indices do not change, only the slot numbers behind them.
+void compactWeb(Web* pWeb) {
+    int* newSlot = (int*)malloc(sizeof(int) * (pWeb->numSlots + 1));
+    int kept = 0;
+    for (int i = 0; i < pWeb->numSlots; i++) {
+        if (pWeb->orgs[i].extinct) {
+            newSlot[i] = -1;
+            continue;
+        }
+        newSlot[i] = kept;
+        pWeb->orgs[kept++] = pWeb->orgs[i];
+    }
+    pWeb->numSlots = kept;
+    countStat(&(stats.bytesCopied), sizeof(Org) * kept);
+    countStat(&(stats.edgesScanned), 2 * pWeb->numRel);
+
+    // Relations only ever point at live slots, so every entry has a new number
+    for (int i = 0; i < kept; i++) {
+        Org* pOrg = &(pWeb->orgs[i]);
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            pOrg->prey[j] = newSlot[pOrg->prey[j]];
+        }
+        for (int j = 0; j < pOrg->numPred; j++) {
+            pOrg->pred[j] = newSlot[pOrg->pred[j]];
+        }
+    }
+    for (int i = 0; i < kept; i++) {
+        syncSlot(pWeb, i);
+    }
+    rebuildLiveTree(pWeb);
+    rebuildNameTable(pWeb);
+    if (pWeb->preyBits != NULL) {
+        rebuildPreyBits(pWeb);
+    }
+    free(newSlot);
+}
+
+// Removes the live organism in slot from the food web and updates relationships, leaving a
+// tombstone. Slot numbers stay valid because nothing is compacted.
+// Only the organism's own prey and predators are touched, so the cost is O(degree).
+void tombstoneSlot(Web* pWeb, int slot) {
+    Org* pExtinct = &(pWeb->orgs[slot]);
+
+    // Its prey each lose one predator; predator lists are unordered, so swap in the last one
+    for (int j = 0; j < pExtinct->numPrey; j++) {
+        Org* pPrey = &(pWeb->orgs[pExtinct->prey[j]]);
+        moveDegree(pWeb->predDegCount, &(pWeb->maxPred), pPrey->numPred, pPrey->numPred - 1);
+        for (int k = 0; k < pPrey->numPred; k++) {
+            if (pPrey->pred[k] == slot) {
+                countStat(&(stats.edgesScanned), k + 1);
+                pPrey->pred[k] = pPrey->pred[--(pPrey->numPred)];
+                break;
+            }
+        }
+        shrinkList(pWeb, &(pPrey->pred), pPrey->numPred, &(pPrey->predCap));
+        syncSlot(pWeb, pExtinct->prey[j]);
+    }
+
+    // Its predators each lose one prey; prey lists keep their order for printing
+    for (int j = 0; j < pExtinct->numPred; j++) {
+        Org* pPred = &(pWeb->orgs[pExtinct->pred[j]]);
+        moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), pPred->numPrey, pPred->numPrey - 1);
+        for (int k = 0; k < pPred->numPrey; k++) {
+            if (pPred->prey[k] == slot) {
+                countStat(&(stats.edgesScanned), k + 1);
+                countStat(&(stats.bytesCopied), sizeof(int) * (pPred->numPrey - k - 1));
+                memmove(&(pPred->prey[k]), &(pPred->prey[k + 1]), sizeof(int) * (pPred->numPrey - k - 1));
+                if (pWeb->weighted) {
+                    memmove(&(pPred->preyWeight[k]), &(pPred->preyWeight[k + 1]), sizeof(float) * (pPred->numPrey - k - 1));
+                }
+                (pPred->numPrey)--;
+                break;
+            }
+        }
+        shrinkPrey(pWeb, pPred);
+        if (pExtinct->numPrey == 0) {
+            (pPred->numBasalPrey)--;
+        }
+        // A predator left with nothing to eat becomes a producer for everything that eats it
+        if (pPred->numPrey == 0) {
+            for (int k = 0; k < pPred->numPred; k++) {
+                (pWeb->orgs[pPred->pred[k]].numBasalPrey)++;
+                pWeb->slotBasal[pPred->pred[k]]++;
+            }
+        }
+        syncSlot(pWeb, pExtinct->pred[j]);
+    }
+
+    // Clear its row of the adjacency matrix and its bit in each predator's row
+    pWeb->numRel -= pExtinct->numPrey + pExtinct->numPred;
+    if (pWeb->preyBits != NULL) {
+        memset(&(pWeb->preyBits[(size_t)slot * pWeb->bitWords]), 0, sizeof(unsigned long long) * pWeb->bitWords);
+        for (int j = 0; j < pExtinct->numPred; j++) {
+            setPreyBit(pWeb, pExtinct->pred[j], slot, false);
+        }
+    }
+
+    // Leave a tombstone in the slot
+    moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), pExtinct->numPrey, -1);
+    moveDegree(pWeb->predDegCount, &(pWeb->maxPred), pExtinct->numPred, -1);
+    freePrey(pWeb, pExtinct); // Free prey array of the organism to be removed
+    if (pExtinct->predCap > 0) {
+        freeList(pWeb, pExtinct->pred, pExtinct->predCap);
+    }
+    pExtinct->pred = NULL;
+    pExtinct->numPred = pExtinct->predCap = 0;
+    eraseName(pWeb, slot);
+    pExtinct->extinct = true;
+    syncSlot(pWeb, slot);
+    (pWeb->numOrg)--;
+    updateLiveTree(pWeb, slot, -1);
+    // Heights can only drop above the extinct organism; they are recomputed on the next display
+    pWeb->heightsValid = false;
+    pWeb->tagsValid = false;
+    pWeb->levelsValid = false;
+    pWeb->reachValid = false;
+}
+
+// Removes an organism from the food web and updates relationships; problems are reported
+// to pOut (NULL for silence).
+// The cost is O(degree) plus an O(N+E) compaction once more than half of the slots are tombstones.
+bool removeOrgFromWeb(Web* pWeb, int index, OutBuf* pOut) {
+    // Check if the index is valid
+    if (index < 0 || index >= pWeb->numOrg) {
+      outStr(pOut, "Invalid extinction index. No organism removed from the food web.");
+      return false;
+    }
+    tombstoneSlot(pWeb, slotOfIndex(pWeb, index));
+
+    if (pWeb->numSlots - pWeb->numOrg > pWeb->numSlots / 2) {
+        compactWeb(pWeb);
+    }
+
+    return true;
+   
+}
+
+// Batched counterpart of removeOrgFromWeb. The organism leaves the indices and the name table
+// at once, so later edits and their messages see the web exactly as if it were gone, but the
+// relations pointing at it stay until applyPending unlinks every such extinction in one pass.
+// Until then only edits may use the web; the counts that depend on the relations are stale.
+bool deferRemoveOrg(Web* pWeb, int index, OutBuf* pOut) {
+    if (index < 0 || index >= pWeb->numOrg) {
+      outStr(pOut, "Invalid extinction index. No organism removed from the food web.");
+      return false;
+    }
+    int slot = slotOfIndex(pWeb, index);
+    eraseName(pWeb, slot);
+    pWeb->orgs[slot].extinct = true;
+    pWeb->slotLive[slot] = 0;
+    (pWeb->numOrg)--;
+    updateLiveTree(pWeb, slot, -1);
+    pWeb->heightsValid = false;
+    pWeb->tagsValid = false;
+    pWeb->levelsValid = false;
+    pWeb->reachValid = false;
+    (pWeb->numPending)++;
+    return true;
+}
+
+// Drops the extinct slots from a relation list, keeping the others in order, along with their
+// entries of the parallel weight list (NULL if none); returns the new length
+int dropExtinct(const Web* pWeb, int* list, float* weights, int num) {
+    int kept = 0;
+    for (int j = 0; j < num; j++) {
+        if (!pWeb->orgs[list[j]].extinct) {
+            if (weights != NULL) {
+                weights[kept] = weights[j];
+            }
+            list[kept++] = list[j];
+        }
+    }
+    return kept;
+}
+
+// Unlinks every extinction deferRemoveOrg queued, in one O(N+E) pass: each list is filtered
+// once however many of its entries died, the counts the relations feed are recounted, and the
+// web is compacted once for the whole batch
+void applyPending(Web* pWeb) {
+    if (pWeb->numPending == 0) {
+        return;
+    }
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        Org* pOrg = &(pWeb->orgs[slot]);
+        countStat(&(stats.edgesScanned), pOrg->numPrey + pOrg->numPred);
+        if (pOrg->extinct) { // Its own lists go (they are already empty if it died unbatched)
+            freePrey(pWeb, pOrg);
+            if (pOrg->predCap > 0) {
+                freeList(pWeb, pOrg->pred, pOrg->predCap);
+            }
+            pOrg->pred = NULL;
+            pOrg->numPred = pOrg->predCap = 0;
+            continue;
+        }
+        pOrg->numPrey = dropExtinct(pWeb, pOrg->prey, pOrg->preyWeight, pOrg->numPrey);
+        pOrg->numPred = dropExtinct(pWeb, pOrg->pred, NULL, pOrg->numPred);
+        shrinkPrey(pWeb, pOrg);
+        shrinkList(pWeb, &(pOrg->pred), pOrg->numPred, &(pOrg->predCap));
     }
 
-    free(pWeb); // Free the main array holding organisms
+    // Recount what the skipped unlinking would have patched
+    for (int d = 0; d < pWeb->capOrg; d++) {
+        pWeb->preyDegCount[d] = 0;
+        pWeb->predDegCount[d] = 0;
+    }
+    pWeb->maxPrey = 0;
+    pWeb->maxPred = 0;
+    pWeb->numRel = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        Org* pOrg = &(pWeb->orgs[slot]);
+        if (pOrg->extinct) {
+            continue;
+        }
+        pOrg->numBasalPrey = 0;
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            if (pWeb->orgs[pOrg->prey[j]].numPrey == 0) {
+                (pOrg->numBasalPrey)++;
+            }
+        }
+        moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), -1, pOrg->numPrey);
+        moveDegree(pWeb->predDegCount, &(pWeb->maxPred), -1, pOrg->numPred);
+        pWeb->numRel += pOrg->numPrey;
+    }
+    pWeb->numPending = 0;
+    compactWeb(pWeb);
+}
+
+// Orders two ints for qsort
+int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Removes the organism at index (which must be valid), then every consumer left with no prey,
+// transitively. A worklist of slots holds the organisms still to die: each removal only checks
+// the predators of the organism it removes, so a cascade costs O(affected edges) instead of
+// repeated scans of the web, and compaction waits until the cascade is over.
+// Returns the number of secondary extinctions; *pLost receives their names in the order they
+// died. If pChanged is not NULL it receives the sorted indices of the survivors that lost prey.
+int cascadeExtinction(Web* pWeb, int index, const char*** pLost, int** pChanged, int* pNumChanged) {
+    int* work = NULL; // Slots still to remove; a consumer enters once, when it loses its last prey
+    int numWork = 0;
+    int capWork = 0;
+    int* touched = NULL; // Slots of every predator of a removed organism
+    int numTouched = 0;
+    int capTouched = 0;
+    appendInt(&work, &numWork, &capWork, slotOfIndex(pWeb, index));
+
+    for (int w = 0; w < numWork; w++) {
+        int slot = work[w];
+        // The predator list goes away with the organism, so note the predators first
+        int firstPred = numTouched;
+        for (int j = 0; j < pWeb->orgs[slot].numPred; j++) {
+            appendInt(&touched, &numTouched, &capTouched, pWeb->orgs[slot].pred[j]);
+        }
+        tombstoneSlot(pWeb, slot);
+        for (int k = firstPred; k < numTouched; k++) {
+            if (pWeb->orgs[touched[k]].numPrey == 0) {
+                appendInt(&work, &numWork, &capWork, touched[k]);
+            }
+        }
+    }
+
+    // Tombstones keep their names until compaction; the names live on in the arena
+    int numLost = numWork - 1;
+    const char** lost = (const char**)malloc(sizeof(char*) * numWork);
+    for (int w = 1; w < numWork; w++) {
+        lost[w - 1] = pWeb->orgs[work[w]].name;
+    }
+
+    // Indices of the survivors come from the live tree, which is current before compaction
+    if (pChanged != NULL) {
+        int* changed = (int*)malloc(sizeof(int) * (numTouched + 1));
+        int numChanged = 0;
+        for (int k = 0; k < numTouched; k++) {
+            if (!pWeb->orgs[touched[k]].extinct) {
+                changed[numChanged++] = indexOfSlot(pWeb, touched[k]);
+            }
+        }
+        // A survivor that lost several prey appears once per lost prey, so sort and drop repeats
+        qsort(changed, numChanged, sizeof(int), compareInts);
+        int numUnique = 0;
+        for (int k = 0; k < numChanged; k++) {
+            if (numUnique == 0 || changed[numUnique - 1] != changed[k]) {
+                changed[numUnique++] = changed[k];
+            }
+        }
+        *pChanged = changed;
+        *pNumChanged = numUnique;
+    }
+    free(work);
+    free(touched);
+
+    if (pWeb->numSlots - pWeb->numOrg > pWeb->numSlots / 2) {
+        compactWeb(pWeb);
+    }
+    *pLost = lost;
+    return numLost;
+}
+
+#define SNAPSHOT_MAGIC "FOODWEB" // First 8 bytes of a snapshot file, NUL included
+#define SNAPSHOT_VERSION 2 // Bumped whenever the snapshot layout changes
+#define SNAPSHOT_WEIGHTS 1 // Header flag: the relation weights are stored
+
+// Struct to represent the header of a binary snapshot of the web. The arrays follow it back
+// to back as 4-byte ints in the writer's byte order, organisms numbered by their index:
+//   preyStart[numOrg + 1], preyIdx[numRel], predStart[numOrg + 1], predIdx[numRel],
+//   numBasalPrey[numOrg], nameHash[numOrg], nameStart[numOrg], with SNAPSHOT_WEIGHTS the
+//   float preyWeight[numRel] parallel to preyIdx, then nameBytes of names.
+// Everything is 4-byte aligned, so a mapped snapshot is used in place without parsing.
+typedef struct SnapshotHeader_struct {
+    char magic[8]; // SNAPSHOT_MAGIC
+    int version; // SNAPSHOT_VERSION of the writer
+    int flags; // SNAPSHOT_WEIGHTS if the web was weighted
+    int numOrg; // Number of organisms
+    int numRel; // Number of predator/prey relations
+    int nameBytes; // Bytes of NUL-terminated names at the end
+} SnapshotHeader;
+
+// Writes the live organisms and relations of the web to a snapshot file; problems are
+// reported to pOut
+bool saveSnapshot(const Web* pWeb, const char* path, OutBuf* pOut) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        outPrintf(pOut, "Could not open snapshot file %s for writing.\n", path);
+        return false;
+    }
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.flags = pWeb->weighted ? SNAPSHOT_WEIGHTS : 0;
+    header.numOrg = pWeb->numOrg;
+    header.numRel = 0;
+    header.nameBytes = 0;
+    int numOrg = pWeb->numOrg;
+    int* dense = (int*)malloc(sizeof(int) * (pWeb->numSlots + 1));
+    int* live = (int*)malloc(sizeof(int) * (numOrg + 1)); // Slot of each organism
+    int i = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            dense[slot] = i;
+            live[i++] = slot;
+            header.numRel += pWeb->orgs[slot].numPrey;
+            header.nameBytes += (int)strlen(pWeb->orgs[slot].name) + 1;
+        }
+    }
+    fwrite(&header, sizeof(header), 1, file);
+
+    // Each array goes out through one scratch buffer big enough for any of them
+    int* scratch = (int*)malloc(sizeof(int) * ((numOrg > header.numRel ? numOrg : header.numRel) + 1));
+    for (int pass = 0; pass < 2; pass++) { // Pass 0 writes the prey lists, pass 1 the predators
+        int total = 0;
+        for (i = 0; i < numOrg; i++) {
+            scratch[i] = total;
+            total += (pass == 0) ? pWeb->orgs[live[i]].numPrey : pWeb->orgs[live[i]].numPred;
+        }
+        scratch[numOrg] = total;
+        fwrite(scratch, sizeof(int), numOrg + 1, file);
+        total = 0;
+        for (i = 0; i < numOrg; i++) {
+            const Org* pOrg = &(pWeb->orgs[live[i]]);
+            const int* list = (pass == 0) ? pOrg->prey : pOrg->pred;
+            int num = (pass == 0) ? pOrg->numPrey : pOrg->numPred;
+            for (int j = 0; j < num; j++) {
+                scratch[total++] = dense[list[j]];
+            }
+        }
+        fwrite(scratch, sizeof(int), total, file);
+    }
+    for (i = 0; i < numOrg; i++) {
+        scratch[i] = pWeb->orgs[live[i]].numBasalPrey;
+    }
+    fwrite(scratch, sizeof(int), numOrg, file);
+    for (i = 0; i < numOrg; i++) {
+        scratch[i] = (int)pWeb->orgs[live[i]].nameHash;
+    }
+    fwrite(scratch, sizeof(int), numOrg, file);
+    int offset = 0;
+    for (i = 0; i < numOrg; i++) {
+        scratch[i] = offset;
+        offset += (int)strlen(pWeb->orgs[live[i]].name) + 1;
+    }
+    fwrite(scratch, sizeof(int), numOrg, file);
+    if (pWeb->weighted) {
+        for (i = 0; i < numOrg; i++) {
+            const Org* pOrg = &(pWeb->orgs[live[i]]);
+            if (pOrg->numPrey > 0) { // A producer has no weight array at all
+                fwrite(pOrg->preyWeight, sizeof(float), pOrg->numPrey, file);
+            }
+        }
+    }
+    for (i = 0; i < numOrg; i++) {
+        const char* name = pWeb->orgs[live[i]].name;
+        fwrite(name, 1, strlen(name) + 1, file);
+    }
+    free(scratch);
+    free(dense);
+    free(live);
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0 || !ok) {
+        outPrintf(pOut, "Could not write snapshot file %s.\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Checks a mapped snapshot before it is used in place, so a damaged file is rejected instead
+// of loading as an inconsistent web: every offset array must be in order, every index in
+// range and every weight (if weights is not NULL) positive; no organism may eat itself or list
+// a prey twice; the predator lists must be exactly the transpose of the prey lists; and the
+// stored producer-prey counts and name hashes must equal the ones recomputed from the data.
+// Costs O(N+E) time and memory.
+bool validSnapshot(const SnapshotHeader* pHeader, const int* preyStart, const int* preyIdx, const int* predStart, const int* predIdx, const int* basal, const int* nameHash, const int* nameStart, const float* weights, const char* names) {
+    int numOrg = pHeader->numOrg;
+    int numRel = pHeader->numRel;
+    if (preyStart[0] != 0 || preyStart[numOrg] != numRel || predStart[0] != 0 || predStart[numOrg] != numRel) {
+        return false;
+    }
+    if (pHeader->nameBytes > 0 && names[pHeader->nameBytes - 1] != '\0') {
+        return false;
+    }
+    for (int i = 0; i < numOrg; i++) {
+        if (preyStart[i] > preyStart[i + 1] || predStart[i] > predStart[i + 1]
+            || nameStart[i] < 0 || nameStart[i] >= pHeader->nameBytes) {
+            return false;
+        }
+        if ((int)hashName(names + nameStart[i]) != nameHash[i]) {
+            return false;
+        }
+    }
+    for (int e = 0; e < numRel; e++) {
+        if (preyIdx[e] < 0 || preyIdx[e] >= numOrg || predIdx[e] < 0 || predIdx[e] >= numOrg) {
+            return false;
+        }
+        if (weights != NULL && !(weights[e] > 0.0f && weights[e] <= 3.4e38f)) {
+            return false;
+        }
+    }
+
+    // stamp[j] is the last organism that listed j; it catches self-loops and repeated prey
+    int* stamp = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* fill = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* transpose = (int*)malloc(sizeof(int) * (numRel + 1));
+    bool valid = true;
+    for (int i = 0; i < numOrg; i++) {
+        stamp[i] = -1;
+        fill[i] = predStart[i];
+    }
+    for (int i = 0; i < numOrg && valid; i++) {
+        stamp[i] = i;
+        int numBasal = 0;
+        for (int e = preyStart[i]; e < preyStart[i + 1] && valid; e++) {
+            int prey = preyIdx[e];
+            valid = (stamp[prey] != i);
+            stamp[prey] = i;
+            if (preyStart[prey] == preyStart[prey + 1]) {
+                numBasal++;
+            }
+            // Scatter the predator lists the prey lists imply; a slot past the stored
+            // list means the in-degrees disagree
+            valid = valid && (fill[prey] < predStart[prey + 1]);
+            if (valid) {
+                transpose[fill[prey]++] = i;
+            }
+        }
+        valid = valid && (numBasal == basal[i]);
+    }
+    // With the in-degrees equal, each stored predator list must match its implied list as a
+    // set: mark the implied predators with the prey, then consume one mark per stored entry
+    for (int i = 0; i < numOrg; i++) {
+        stamp[i] = -1;
+    }
+    for (int prey = 0; prey < numOrg && valid; prey++) {
+        valid = (fill[prey] == predStart[prey + 1]);
+        for (int e = predStart[prey]; e < predStart[prey + 1] && valid; e++) {
+            stamp[transpose[e]] = prey;
+        }
+        for (int e = predStart[prey]; e < predStart[prey + 1] && valid; e++) {
+            valid = (stamp[predIdx[e]] == prey);
+            stamp[predIdx[e]] = -1;
+        }
+    }
+    free(stamp);
+    free(fill);
+    free(transpose);
+    countStat(&(stats.edgesScanned), 2 * (long long)numRel);
+    return valid;
+}
+
+// Replaces the (empty) web with the contents of a snapshot file; problems are reported to pOut.
+// The file is mapped copy-on-write and the organisms' names and lists point straight into it,
+// so loading costs one pass over the organisms and no allocation per organism. A list moves
+// to the list arena only when it has to grow (see moveList). A weighted web loaded from a
+// snapshot without weights gives every relation weight 1; an unweighted web ignores weights.
+bool loadSnapshot(Web* pWeb, const char* path, OutBuf* pOut) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        outPrintf(pOut, "Could not open snapshot file %s.\n", path);
+        return false;
+    }
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(fileno(file), &info) == 0 && info.st_size >= (off_t)sizeof(SnapshotHeader)) {
+        map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+    }
+    fclose(file); // The mapping stays valid without the file
+    if (map == MAP_FAILED) {
+        outPrintf(pOut, "Could not read snapshot file %s.\n", path);
+        return false;
+    }
+    size_t len = (size_t)info.st_size;
+
+    const SnapshotHeader* pHeader = (const SnapshotHeader*)map;
+    if (memcmp(pHeader->magic, SNAPSHOT_MAGIC, sizeof(pHeader->magic)) != 0 || pHeader->version != SNAPSHOT_VERSION) {
+        outPrintf(pOut, "Snapshot file %s is not a version %d food web snapshot.\n", path, SNAPSHOT_VERSION);
+        munmap(map, len);
+        return false;
+    }
+    int numOrg = pHeader->numOrg;
+    int numRel = pHeader->numRel;
+    bool hasWeights = (pHeader->flags & SNAPSHOT_WEIGHTS) != 0;
+    size_t numInts = 2 * ((size_t)numOrg + 1) + 2 * (size_t)numRel + 3 * (size_t)numOrg;
+    if (hasWeights) {
+        numInts += (size_t)numRel; // A float is the size of an int
+    }
+    if (numOrg < 0 || numRel < 0 || pHeader->nameBytes < 0
+        || len != sizeof(SnapshotHeader) + sizeof(int) * numInts + (size_t)pHeader->nameBytes) {
+        outPrintf(pOut, "Snapshot file %s is damaged.\n", path);
+        munmap(map, len);
+        return false;
+    }
+    int* preyStart = (int*)((char*)map + sizeof(SnapshotHeader));
+    int* preyIdx = preyStart + numOrg + 1;
+    int* predStart = preyIdx + numRel;
+    int* predIdx = predStart + numOrg + 1;
+    int* basal = predIdx + numRel;
+    int* nameHash = basal + numOrg;
+    int* nameStart = nameHash + numOrg;
+    float* weights = hasWeights ? (float*)(nameStart + numOrg) : NULL;
+    const char* names = (const char*)(nameStart + numOrg + (hasWeights ? numRel : 0));
+    if (!validSnapshot(pHeader, preyStart, preyIdx, predStart, predIdx, basal, nameHash, nameStart, weights, names)) {
+        outPrintf(pOut, "Snapshot file %s is damaged.\n", path);
+        munmap(map, len);
+        return false;
+    }
+
+    pWeb->snapshot = (char*)map;
+    pWeb->snapshotLen = len;
+    if (numOrg == 0) {
+        return true;
+    }
+    int cap = numOrg;
+    pWeb->orgs = (Org*)malloc(sizeof(Org) * cap);
+    pWeb->liveTree = (int*)malloc(sizeof(int) * (cap + 1));
+    pWeb->preyDegCount = (int*)calloc(cap, sizeof(int));
+    pWeb->predDegCount = (int*)calloc(cap, sizeof(int));
+    pWeb->tags = (unsigned char*)malloc(cap);
+    pWeb->raiseQueued = (unsigned char*)calloc(cap, 1);
+    pWeb->capOrg = cap;
+    resizeSlotArrays(pWeb);
+    for (int i = 0; i < numOrg; i++) {
+        Org* pOrg = &(pWeb->orgs[i]);
+        pOrg->name = names + nameStart[i];
+        pOrg->nameHash = (unsigned int)nameHash[i];
+        // Index i is slot i, so the stored indices are the slot numbers the lists need
+        pOrg->numPrey = preyStart[i + 1] - preyStart[i];
+        pOrg->prey = (pOrg->numPrey > 0) ? &(preyIdx[preyStart[i]]) : NULL;
+        pOrg->preyCap = (pOrg->numPrey > 0) ? -1 : 0;
+        pOrg->preyWeight = NULL;
+        if (pWeb->weighted && pOrg->numPrey > 0 && weights != NULL) {
+            pOrg->preyWeight = &(weights[preyStart[i]]);
+        }
+        else if (pWeb->weighted && pOrg->numPrey > 0) { // Weights go in the arena, beside a copy of the prey
+            moveList(pWeb, &(pOrg->prey), pOrg->numPrey, &(pOrg->preyCap), pOrg->numPrey);
+            pOrg->preyWeight = (float*)allocList(pWeb, pOrg->preyCap);
+            for (int j = 0; j < pOrg->numPrey; j++) {
+                pOrg->preyWeight[j] = 1.0f;
+            }
+        }
+        pOrg->numPred = predStart[i + 1] - predStart[i];
+        pOrg->pred = (pOrg->numPred > 0) ? &(predIdx[predStart[i]]) : NULL;
+        pOrg->predCap = (pOrg->numPred > 0) ? -1 : 0;
+        pOrg->extinct = false;
+        pOrg->numBasalPrey = basal[i];
+        pOrg->height = 0;
+        pOrg->cycle = i;
+        syncSlot(pWeb, i);
+        moveDegree(pWeb->preyDegCount, &(pWeb->maxPrey), -1, pOrg->numPrey);
+        moveDegree(pWeb->predDegCount, &(pWeb->maxPred), -1, pOrg->numPred);
+    }
+    pWeb->numSlots = pWeb->numOrg = numOrg;
+    pWeb->numRel = numRel;
+    pWeb->numCycleIds = numOrg;
+    pWeb->heightsValid = false; // Computed on the first display
+    pWeb->tagsValid = false;
+    pWeb->levelsValid = false;
+    pWeb->reachValid = false;
+    rebuildLiveTree(pWeb);
+
+    // Size the name table for every organism up front, then fill it
+    int tableCap = 16;
+    while (tableCap < 4 * (numOrg + 1)) {
+        tableCap *= 2;
+    }
+    pWeb->nameTable = (int*)malloc(sizeof(int) * tableCap);
+    pWeb->nameTableCap = tableCap;
+    rebuildNameTable(pWeb);
+    rebuildPreyBits(pWeb);
+    return true;
+}
+
+#define JOURNAL_MAGIC "FWJOURN" // First 8 bytes of a journal file, NUL included
+#define JOURNAL_VERSION 2 // Bumped whenever the journal layout changes
+#define JOURNAL_CHECKPOINT_EDITS 100000 // Default number of edits between checkpoints
+#define JOURNAL_ORG 'o' // Record: a new organism, then a length byte and the name
+#define JOURNAL_RELATION 'r' // Record: a new relation, then the predator and prey index and the weight
+#define JOURNAL_EXTINCTION 'x' // Record: an extinction, then the index
+#define JOURNAL_CASCADE 'c' // Record: an extinction with its cascade, then the index
+#define JOURNAL_COMMAND 'n' // Record: a modification command that changed nothing, no operands
+
+// Struct to represent the header of a journal file. The records of the edits applied since
+// the checkpoint follow it back to back, each an opcode byte and its operands in the writer's
+// byte order. The web the records start from is the checkpoint file <journal>.<generation>.
+typedef struct JournalHeader_struct {
+    char magic[8]; // JOURNAL_MAGIC
+    int version; // JOURNAL_VERSION of the writer
+    int generation; // Checkpoint file the records follow (0 or 1)
+    long long baseEdits; // Edits of the whole run already in the checkpoint
+    long long baseCommands; // Modification commands of the input already in the checkpoint
+} JournalHeader;
+
+// Struct to represent the journal of a run (-j): every applied edit is appended to the journal
+// file as a compact binary record, and every interval edits the web is written to a checkpoint
+// and the journal starts over, so recovering after a crash replays at most interval records.
+// Checkpoints alternate between two files: the new one is complete before a journal naming it
+// replaces the old journal, so a crash at any point leaves a checkpoint and journal that match.
+typedef struct Journal_struct {
+    const char* path; // Journal file
+    int fd; // The open journal, or -1 before the first checkpoint
+    int generation; // Checkpoint file the journal's records follow, -1 before the first
+    long long baseEdits; // Edits of the whole run in that checkpoint
+    long long numEdits; // Edits recorded in the journal since it
+    long long baseCommands; // Modification commands of the input in that checkpoint
+    long long numCommands; // Modification commands recorded since it, edits included
+    long long interval; // Edits between checkpoints
+} Journal;
+
+// Initializes a journal that has no checkpoint yet
+void initJournal(Journal* pJournal, const char* path, long long interval) {
+    pJournal->path = path;
+    pJournal->fd = -1;
+    pJournal->generation = -1;
+    pJournal->baseEdits = 0;
+    pJournal->numEdits = 0;
+    pJournal->baseCommands = 0;
+    pJournal->numCommands = 0;
+    pJournal->interval = (interval > 0) ? interval : JOURNAL_CHECKPOINT_EDITS;
+}
+
+// Returns the name of a checkpoint file or of the journal's temporary file (a malloc'd string)
+char* journalFileName(const Journal* pJournal, const char* suffix) {
+    size_t len = strlen(pJournal->path) + strlen(suffix) + 1;
+    char* name = (char*)malloc(len);
+    snprintf(name, len, "%s%s", pJournal->path, suffix);
+    return name;
+}
+
+// Forces a written file to disk, so a checkpoint survives a system crash as well
+bool syncFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = (fsync(fd) == 0);
+    close(fd);
+    return ok;
+}
+
+// Writes the web to the other checkpoint file and starts an empty journal after it; problems
+// are reported to pOut. Batched extinctions are applied first, since a checkpoint holds only
+// live organisms. Both files are written under a temporary name and renamed into place, which
+// also keeps a web recovered from the older checkpoint, and still mapped from it, intact.
+bool checkpointJournal(Journal* pJournal, Web* pWeb, OutBuf* pOut) {
+    double start = startPhase();
+    applyPending(pWeb);
+    int generation = (pJournal->generation == 0) ? 1 : 0;
+    char* checkpoint = journalFileName(pJournal, (generation == 0) ? ".0" : ".1");
+    char* temp = journalFileName(pJournal, ".tmp");
+    bool ok = saveSnapshot(pWeb, temp, pOut) && syncFile(temp) && rename(temp, checkpoint) == 0;
+
+    JournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.generation = generation;
+    header.baseEdits = pJournal->baseEdits + pJournal->numEdits;
+    header.baseCommands = pJournal->baseCommands + pJournal->numCommands;
+    int fd = ok ? open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    ok = ok && fd != -1 && write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) && fsync(fd) == 0;
+    // The rename is the moment the new checkpoint takes over from the old one
+    ok = ok && rename(temp, pJournal->path) == 0;
+    if (ok) {
+        if (pJournal->fd != -1) {
+            close(pJournal->fd);
+        }
+        pJournal->fd = fd;
+        pJournal->generation = generation;
+        pJournal->baseEdits = header.baseEdits;
+        pJournal->numEdits = 0;
+        pJournal->baseCommands = header.baseCommands;
+        pJournal->numCommands = 0;
+    }
+    else {
+        outPrintf(pOut, "Could not write a checkpoint of journal %s.\n", pJournal->path);
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    free(checkpoint);
+    free(temp);
+    endPhase(PHASE_JOURNAL, start);
+    return ok;
+}
+
+// Appends one record to the journal with a single write, so a crash can only cut off the
+// last record; takes a checkpoint once interval edits have been recorded
+void appendRecord(Journal* pJournal, Web* pWeb, const char* record, size_t len, OutBuf* pOut) {
+    if (write(pJournal->fd, record, len) != (ssize_t)len) {
+        outPrintf(pOut, "Could not write to journal %s.\n", pJournal->path);
+    }
+    (pJournal->numEdits)++;
+    (pJournal->numCommands)++;
+    if (pJournal->numEdits >= pJournal->interval) {
+        checkpointJournal(pJournal, pWeb, pOut);
+    }
+}
+
+// Records a modification command that changed nothing (a display, a query or an invalid edit),
+// so the journal knows how far into the input the run got; it does not count as an edit
+void journalCommand(Journal* pJournal, OutBuf* pOut) {
+    char record = JOURNAL_COMMAND;
+    if (write(pJournal->fd, &record, 1) != 1) {
+        outPrintf(pOut, "Could not write to journal %s.\n", pJournal->path);
+    }
+    (pJournal->numCommands)++;
+}
+
+// Records a new organism
+void journalOrg(Journal* pJournal, Web* pWeb, const char* name, OutBuf* pOut) {
+    char record[2 + MAX_NAME_LEN];
+    size_t len = strlen(name);
+    record[0] = JOURNAL_ORG;
+    record[1] = (char)(unsigned char)len; // Names never exceed MAX_NAME_LEN (255) characters
+    memcpy(&(record[2]), name, len);
+    appendRecord(pJournal, pWeb, record, 2 + len, pOut);
+}
+
+// Records a new relation between the organisms at two indices
+void journalRelation(Journal* pJournal, Web* pWeb, int predInd, int preyInd, double weight, OutBuf* pOut) {
+    char record[1 + 2 * sizeof(int) + sizeof(float)];
+    float value = (float)weight;
+    record[0] = JOURNAL_RELATION;
+    memcpy(&(record[1]), &predInd, sizeof(int));
+    memcpy(&(record[1 + sizeof(int)]), &preyInd, sizeof(int));
+    memcpy(&(record[1 + 2 * sizeof(int)]), &value, sizeof(float));
+    appendRecord(pJournal, pWeb, record, sizeof(record), pOut);
+}
+
+// Records the extinction of the organism at an index, with its cascade if cascade is set
+void journalExtinction(Journal* pJournal, Web* pWeb, int index, bool cascade, OutBuf* pOut) {
+    char record[1 + sizeof(int)];
+    record[0] = cascade ? JOURNAL_CASCADE : JOURNAL_EXTINCTION;
+    memcpy(&(record[1]), &index, sizeof(int));
+    appendRecord(pJournal, pWeb, record, sizeof(record), pOut);
+}
+
+// Rebuilds the web (which must be empty) from the journal's checkpoint and replays the records
+// after it; problems are reported to pOut. A record cut off by a crash ends the replay, and
+// the next checkpoint drops it. Returns false if the journal or its checkpoint cannot be used.
+bool recoverJournal(Journal* pJournal, Web* pWeb, OutBuf* pOut) {
+    double start = startPhase();
+    FILE* file = fopen(pJournal->path, "rb");
+    JournalHeader header;
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1
+        || memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || header.version != JOURNAL_VERSION
+        || (header.generation != 0 && header.generation != 1)) {
+        outPrintf(pOut, "Journal %s is not a version %d food web journal.\n", pJournal->path, JOURNAL_VERSION);
+        if (file != NULL) {
+            fclose(file);
+        }
+        endPhase(PHASE_JOURNAL, start);
+        return false;
+    }
+    char* checkpoint = journalFileName(pJournal, (header.generation == 0) ? ".0" : ".1");
+    bool ok = loadSnapshot(pWeb, checkpoint, pOut);
+    free(checkpoint);
+    pJournal->generation = header.generation;
+    pJournal->baseEdits = header.baseEdits;
+    pJournal->numEdits = 0;
+    pJournal->baseCommands = header.baseCommands;
+    pJournal->numCommands = 0;
+
+    int op;
+    while (ok && (op = getc(file)) != EOF) {
+        char name[MAX_NAME_LEN + 1];
+        int a, b;
+        float weight;
+        if (op == JOURNAL_ORG) {
+            int len = getc(file);
+            if (len == EOF || fread(name, 1, len, file) != (size_t)len) {
+                break;
+            }
+            name[len] = '\0';
+            addOrgToWeb(pWeb, name);
+        }
+        else if (op == JOURNAL_RELATION) {
+            if (fread(&a, sizeof(int), 1, file) != 1 || fread(&b, sizeof(int), 1, file) != 1
+                || fread(&weight, sizeof(float), 1, file) != 1) {
+                break;
+            }
+            addWeightedRelationToWeb(pWeb, a, b, weight, NULL);
+        }
+        else if ((op == JOURNAL_EXTINCTION || op == JOURNAL_CASCADE) && fread(&a, sizeof(int), 1, file) == 1) {
+            if (op == JOURNAL_CASCADE && a >= 0 && a < pWeb->numOrg) {
+                const char** lost = NULL;
+                cascadeExtinction(pWeb, a, &lost, NULL, NULL);
+                free(lost);
+            }
+            else {
+                removeOrgFromWeb(pWeb, a, NULL);
+            }
+        }
+        else if (op == JOURNAL_COMMAND) {
+            (pJournal->numCommands)++;
+            continue;
+        }
+        else {
+            break; // A cut-off or unknown record ends the journal
+        }
+        (pJournal->numEdits)++;
+        (pJournal->numCommands)++;
+    }
+    fclose(file);
+    endPhase(PHASE_JOURNAL, start);
+    return ok;
+}
+
+// Closes the journal; the journal and its checkpoint stay on disk for the next recovery
+void closeJournal(Journal* pJournal) {
+    if (pJournal->fd != -1) {
+        close(pJournal->fd);
+        pJournal->fd = -1;
+    }
+}
+
+// Closes the journal of a run that ended normally and removes it, so the next run builds its
+// web from the input again. The journal goes first: once it is gone nothing recovers from the
+// checkpoints, which are removed after it.
+void finishJournal(Journal* pJournal) {
+    closeJournal(pJournal);
+    unlink(pJournal->path);
+    const char* suffixes[] = { ".0", ".1", ".tmp" };
+    for (int k = 0; k < 3; k++) {
+        char* name = journalFileName(pJournal, suffixes[k]);
+        unlink(name);
+        free(name);
+    }
+}
+
+// Struct to represent a fixed pool of worker threads that run the tasks of one parallel
+// job at a time. The calling thread works on the job too, so a pool of N threads has
+// N - 1 workers.
+typedef struct ThreadPool_struct {
+    pthread_t* workers; // The worker threads
+    int numWorkers; // Number of worker threads
+    pthread_mutex_t lock; // Guards every field below
+    pthread_cond_t wake; // Signaled when a new job is posted or the pool stops
+    pthread_cond_t done; // Signaled when the last task of a job finishes
+    void (*task)(void* ctx, int taskNum); // Runs one task of the current job
+    void* ctx; // Shared argument of the current job
+    int numTasks; // Number of tasks in the current job
+    int nextTask; // Next task nobody has claimed yet
+    int tasksLeft; // Tasks not finished yet
+    unsigned long job; // Incremented for every posted job
+    bool stop; // The pool is shutting down
+} ThreadPool;
+
+// Claims and runs tasks of the current job until none are left; called with the lock held
+void runTasks(ThreadPool* pPool) {
+    while (pPool->nextTask < pPool->numTasks) {
+        int taskNum = pPool->nextTask++;
+        void (*task)(void*, int) = pPool->task;
+        void* ctx = pPool->ctx;
+        pthread_mutex_unlock(&(pPool->lock));
+        task(ctx, taskNum);
+        pthread_mutex_lock(&(pPool->lock));
+        if (--(pPool->tasksLeft) == 0) {
+            pthread_cond_broadcast(&(pPool->done));
+        }
+    }
+}
+
+// Body of each worker thread: sleep until a job is posted, then help run it
+void* poolWorker(void* arg) {
+    ThreadPool* pPool = (ThreadPool*)arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&(pPool->lock));
+    while (true) {
+        while (!pPool->stop && pPool->job == seen) {
+            pthread_cond_wait(&(pPool->wake), &(pPool->lock));
+        }
+        if (pPool->stop) {
+            break;
+        }
+        seen = pPool->job;
+        runTasks(pPool);
+    }
+    pthread_mutex_unlock(&(pPool->lock));
+    return NULL;
+}
+
+// Starts a pool of numThreads threads in total (the caller counts as one)
+void initPool(ThreadPool* pPool, int numThreads) {
+    pPool->numWorkers = (numThreads > 1) ? numThreads - 1 : 0;
+    pPool->workers = (pthread_t*)malloc(sizeof(pthread_t) * (pPool->numWorkers + 1));
+    pthread_mutex_init(&(pPool->lock), NULL);
+    pthread_cond_init(&(pPool->wake), NULL);
+    pthread_cond_init(&(pPool->done), NULL);
+    pPool->task = NULL;
+    pPool->ctx = NULL;
+    pPool->numTasks = pPool->nextTask = pPool->tasksLeft = 0;
+    pPool->job = 0;
+    pPool->stop = false;
+    for (int t = 0; t < pPool->numWorkers; t++) {
+        pthread_create(&(pPool->workers[t]), NULL, poolWorker, pPool);
+    }
+}
+
+// Runs task(ctx, 0) .. task(ctx, numTasks - 1) across the pool and returns when all are done.
+// A NULL pool runs them in order on the calling thread.
+void runParallel(ThreadPool* pPool, int numTasks, void (*task)(void*, int), void* ctx) {
+    if (pPool == NULL || pPool->numWorkers == 0 || numTasks <= 1) {
+        for (int t = 0; t < numTasks; t++) {
+            task(ctx, t);
+        }
+        return;
+    }
+    pthread_mutex_lock(&(pPool->lock));
+    pPool->task = task;
+    pPool->ctx = ctx;
+    pPool->numTasks = numTasks;
+    pPool->nextTask = 0;
+    pPool->tasksLeft = numTasks;
+    (pPool->job)++;
+    pthread_cond_broadcast(&(pPool->wake));
+    runTasks(pPool);
+    while (pPool->tasksLeft > 0) {
+        pthread_cond_wait(&(pPool->done), &(pPool->lock));
+    }
+    pthread_mutex_unlock(&(pPool->lock));
+}
+
+// Stops the workers and frees the pool
+void freePool(ThreadPool* pPool) {
+    pthread_mutex_lock(&(pPool->lock));
+    pPool->stop = true;
+    pthread_cond_broadcast(&(pPool->wake));
+    pthread_mutex_unlock(&(pPool->lock));
+    for (int t = 0; t < pPool->numWorkers; t++) {
+        pthread_join(pPool->workers[t], NULL);
+    }
+    free(pPool->workers);
+    pthread_mutex_destroy(&(pPool->lock));
+    pthread_cond_destroy(&(pPool->wake));
+    pthread_cond_destroy(&(pPool->done));
+}
+
+// Struct to represent a read-only snapshot of the web in compressed sparse row (CSR) form.
+// The prey of organism i are preyIdx[preyStart[i]] .. preyIdx[preyStart[i + 1] - 1] and its
+// predators are predIdx[predStart[i]] .. predIdx[predStart[i + 1] - 1], so every analysis
+// pass walks a few contiguous arrays instead of chasing one prey pointer per organism.
+typedef struct FrozenWeb_struct {
+    int numOrg; // Number of organisms in the snapshot
+    int numRel; // Number of predator/prey relations in the snapshot
+    const char** names; // Name of each organism (points into the web's name arena)
+    int* slots; // Web slot of each organism, where results computed on the snapshot go back
+    int* preyStart; // Offsets into preyIdx, numOrg + 1 entries
+    int* preyIdx; // Flat array of prey indices
+    float* preyWeight; // Weight of each entry of preyIdx, or NULL for an unweighted web
+    int* predStart; // Offsets into predIdx, numOrg + 1 entries
+    int* predIdx; // Flat array of predator indices (the reverse relation)
+} FrozenWeb;
+
+// Builds the CSR snapshot of the live organisms, numbered by their user-visible index.
+void freezeWeb(const Web* pWeb, FrozenWeb* pFw) {
+    int numOrg = pWeb->numOrg;
+    pFw->numOrg = numOrg;
+    pFw->names = (const char**)malloc(sizeof(char*) * (numOrg + 1));
+    pFw->slots = (int*)malloc(sizeof(int) * (numOrg + 1));
+    pFw->preyStart = (int*)malloc(sizeof(int) * (numOrg + 1));
+    pFw->predStart = (int*)malloc(sizeof(int) * (numOrg + 1));
+
+    // Number the live slots densely and lay out the prey lists back to back
+    int* dense = (int*)malloc(sizeof(int) * (pWeb->numSlots + 1));
+    int numRel = 0;
+    int i = 0;
+    pFw->predStart[0] = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        const Org* pOrg = &(pWeb->orgs[slot]);
+        if (pOrg->extinct) {
+            continue;
+        }
+        dense[slot] = i;
+        pFw->names[i] = pOrg->name;
+        pFw->slots[i] = slot;
+        pFw->preyStart[i] = numRel;
+        numRel += pOrg->numPrey;
+        // The predator lists are laid out from the maintained in-degrees
+        pFw->predStart[i + 1] = pFw->predStart[i] + pOrg->numPred;
+        i++;
+    }
+    pFw->preyStart[numOrg] = numRel;
+    pFw->numRel = numRel;
+    pFw->preyIdx = (int*)malloc(sizeof(int) * (numRel + 1));
+    pFw->predIdx = (int*)malloc(sizeof(int) * (numRel + 1));
+    pFw->preyWeight = pWeb->weighted ? (float*)malloc(sizeof(float) * (numRel + 1)) : NULL;
+    i = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        const Org* pOrg = &(pWeb->orgs[slot]);
+        if (pOrg->extinct) {
+            continue;
+        }
+        if (pFw->preyWeight != NULL && pOrg->numPrey > 0) {
+            memcpy(&(pFw->preyWeight[pFw->preyStart[i]]), pOrg->preyWeight, sizeof(float) * pOrg->numPrey);
+        }
+        int* out = &(pFw->preyIdx[pFw->preyStart[i++]]);
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            out[j] = dense[pOrg->prey[j]];
+        }
+    }
+    free(dense);
+
+    // Scatter the reverse (predator) lists so each one comes out in index order
+    int* fill = (int*)malloc(sizeof(int) * (numOrg + 1));
+    memcpy(fill, pFw->predStart, sizeof(int) * (numOrg + 1));
+    for (i = 0; i < numOrg; i++) {
+        for (int e = pFw->preyStart[i]; e < pFw->preyStart[i + 1]; e++) {
+            pFw->predIdx[fill[pFw->preyIdx[e]]++] = i;
+        }
+    }
+    free(fill);
+    countStat(&(stats.allocations), 8);
+    countStat(&(stats.edgesScanned), 2 * (long long)numRel);
+}
+
+// Frees the memory allocated for a CSR snapshot
+void freeFrozenWeb(FrozenWeb* pFw) {
+    free(pFw->names);
+    free(pFw->slots);
+    free(pFw->preyStart);
+    free(pFw->preyIdx);
+    free(pFw->preyWeight);
+    free(pFw->predStart);
+    free(pFw->predIdx);
+}
+
+// Prints one organism's line of the food web listing
+void printOrg(OutBuf* pOut, const Web* pWeb, int index, const Org* pOrg) {
+    outPrintf(pOut, "  (%d) ", index);
+    outStr(pOut, pOrg->name);
+    if (pOrg->numPrey > 0) {
+        outStr(pOut, " eats ");
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            if (j != (pOrg->numPrey - 1)) {
+                outStr(pOut, pWeb->orgs[pOrg->prey[j]].name);
+                outStr(pOut, ", ");
+            }
+            else {
+                outStr(pOut, pWeb->orgs[pOrg->prey[j]].name);
+            }
+        }
+    }
+    outStr(pOut, "\n");
+}
+
+// Prints the food web with organism names and their prey
+void printWeb(OutBuf* pOut, const Web* pWeb) {
+    int i = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            printOrg(pOut, pWeb, i++, &(pWeb->orgs[slot]));
+        }
+    }
+}
+
+// Prints one name of an analysis list at the given indentation
+void printName(OutBuf* pOut, const char* indent, const char* name) {
+    outStr(pOut, indent);
+    outStr(pOut, name);
+    outStr(pOut, "\n");
+}
+
+#define TAG_PRODUCER 1 // Eats nothing
+#define TAG_HERBIVORE 2 // Eats only producers
+#define TAG_OMNIVORE 4 // Eats producers and non-producers
+#define TAG_CARNIVORE 8 // Eats only non-producers
+#define TAG_FLEXIBLE 16 // Eats as many prey as any organism does
+#define TAG_APEX 32 // Nothing eats it
+#define TAG_TASTIEST 64 // Eaten by as many predators as any organism is
+
+#define CLASSIFY_LANES 16 // Slots classified per fixed-length inner loop
+
+// Returns the TAG_* bits of a live organism with the given degrees, in branch-free integer
+// arithmetic; static inline so that it is inlined before the loop below is vectorized
+static inline int classifyTag(int numPrey, int basal, int numPred, int maxPrey, int maxPred) {
+    int eats = (numPrey > 0);
+    return (numPrey == 0) * TAG_PRODUCER
+        | (eats & (basal == numPrey)) * TAG_HERBIVORE
+        | ((basal > 0) & (basal < numPrey)) * TAG_OMNIVORE
+        | (eats & (basal == 0)) * TAG_CARNIVORE
+        | (numPrey == maxPrey) * TAG_FLEXIBLE
+        | (numPred == 0) * TAG_APEX
+        | (numPred == maxPred) * TAG_TASTIEST;
+}
+
+// Classifies the slots from .. to - 1 into TAG_* bits from the web's flat degree arrays, with
+// no prey list walks and no Org records touched. The work goes in blocks of CLASSIFY_LANES
+// slots: GCC at -O2 only vectorizes loops whose trip count is known and whose arrays cannot
+// overlap, hence the fixed inner loop and the restrict pointers. Extinct slots get no tag.
+void classifyRange(const int* restrict numPrey, const int* restrict numBasal, const int* restrict numPred,
+    const unsigned char* restrict live, unsigned char* restrict tags, int from, int to, int maxPrey, int maxPred) {
+    int i = from;
+    for (; i + CLASSIFY_LANES <= to; i += CLASSIFY_LANES) {
+        for (int k = 0; k < CLASSIFY_LANES; k++) {
+            int tag = classifyTag(numPrey[i + k], numBasal[i + k], numPred[i + k], maxPrey, maxPred);
+            tags[i + k] = (unsigned char)(tag * live[i + k]);
+        }
+    }
+    for (; i < to; i++) { // The last partial block
+        tags[i] = (unsigned char)(classifyTag(numPrey[i], numBasal[i], numPred[i], maxPrey, maxPred) * live[i]);
+    }
+}
+
+// Prints the name of every organism whose tag has the given bit
+void printTagged(OutBuf* pOut, const Web* pWeb, const char* indent, unsigned char bit) {
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (pWeb->tags[slot] & bit) {
+            printName(pOut, indent, pWeb->orgs[slot].name);
+        }
+    }
+}
+
+// The sections below read the tags, which displayAll brings up to date before printing
+
+// Finds and prints apex predators 
+void apexPredators(OutBuf* pOut, const Web* pWeb) {
+    // An apex predator is never preyed upon, i.e. has an in-degree of zero
+    printTagged(pOut, pWeb, "  ", TAG_APEX);
+}
+
+// Finds and prints all producers
+void producers(OutBuf* pOut, const Web* pWeb) {
+    printTagged(pOut, pWeb, "  ", TAG_PRODUCER);
+}
+
+// Finds and prints the most flexible eaters
+void mostFlexibleEaters(OutBuf* pOut, const Web* pWeb) {
+    // The prey-count histogram gave the classification the maximum
+    printTagged(pOut, pWeb, "  ", TAG_FLEXIBLE);
+}
+
+// Finds and prints the most tasty organism 
+void tastiestFood(OutBuf* pOut, const Web* pWeb) {
+    // The in-degrees shared with apexPredators count how many times each organism is prey
+    printTagged(pOut, pWeb, "  ", TAG_TASTIEST);
+}
+
+// Computes the height of every organism in O(N+E) with an iterative Tarjan pass over the
+// eats relation. Tarjan finishes a strongly connected component only after every component
+// it eats, so components come out in the order heights must be assigned. Organisms caught
+// in a feeding cycle (mutual predation) share one height: one more than the tallest prey
+// outside the cycle, and at least 1 since every member eats something. comp[i] receives the
+// component of organism i; returns the number of components.
+int computeHeights(const FrozenWeb* pFw, int* height, int* comp) {
+    int numOrg = pFw->numOrg;
+    int* order = (int*)malloc(sizeof(int) * (numOrg + 1)); // Discovery order, -1 if unvisited
+    int* low = (int*)malloc(sizeof(int) * (numOrg + 1)); // Lowest discovery order reachable
+    int* next = (int*)malloc(sizeof(int) * (numOrg + 1)); // Next prey edge to explore
+    int* stack = (int*)malloc(sizeof(int) * (numOrg + 1)); // Tarjan component stack
+    int* path = (int*)malloc(sizeof(int) * (numOrg + 1)); // Explicit DFS call stack
+    bool* onStack = (bool*)calloc(numOrg + 1, sizeof(bool));
+    int numComp = 0;
+    int counter = 0;
+    int stackTop = 0;
+
+    for (int i = 0; i < numOrg; i++) {
+        order[i] = -1;
+    }
+
+    for (int root = 0; root < numOrg; root++) {
+        if (order[root] != -1) {
+            continue;
+        }
+        int pathTop = 0;
+        path[pathTop++] = root;
+        order[root] = low[root] = counter++;
+        next[root] = pFw->preyStart[root];
+        stack[stackTop++] = root;
+        onStack[root] = true;
+
+        while (pathTop > 0) {
+            int v = path[pathTop - 1];
+            if (next[v] < pFw->preyStart[v + 1]) {
+                int w = pFw->preyIdx[next[v]++];
+                if (order[w] == -1) { // Descend into an unvisited prey
+                    order[w] = low[w] = counter++;
+                    next[w] = pFw->preyStart[w];
+                    stack[stackTop++] = w;
+                    onStack[w] = true;
+                    path[pathTop++] = w;
+                }
+                else if (onStack[w] && order[w] < low[v]) {
+                    low[v] = order[w];
+                }
+                continue;
+            }
+
+            // All prey of v are explored
+            pathTop--;
+            if (pathTop > 0 && low[v] < low[path[pathTop - 1]]) {
+                low[path[pathTop - 1]] = low[v];
+            }
+            if (low[v] != order[v]) {
+                continue;
+            }
+
+            // v is the root of a component: pop its members, then give them all one height
+            int first = stackTop;
+            do {
+                first--;
+                onStack[stack[first]] = false;
+                comp[stack[first]] = numComp;
+            } while (stack[first] != v);
+            int compHeight = (stackTop - first > 1) ? 1 : 0;
+            for (int m = first; m < stackTop; m++) {
+                int member = stack[m];
+                for (int e = pFw->preyStart[member]; e < pFw->preyStart[member + 1]; e++) {
+                    int prey = pFw->preyIdx[e];
+                    if (comp[prey] != numComp && height[prey] + 1 > compHeight) {
+                        compHeight = height[prey] + 1;
+                    }
+                }
+            }
+            for (int m = first; m < stackTop; m++) {
+                height[stack[m]] = compHeight;
+            }
+            stackTop = first;
+            numComp++;
+        }
+    }
+
+    free(order);
+    free(low);
+    free(next);
+    free(stack);
+    free(path);
+    free(onStack);
+    countStat(&(stats.edgesScanned), 2 * (long long)pFw->numRel); // The search, then the heights
+    return numComp;
+}
+
+#define LEVEL_MIN_RELATIONS 65536 // Fewest relations worth spreading the heights over the pool
+#define LEVEL_CHUNK 4096 // Frontier organisms per task of one level
+
+// Struct to represent the shared state of levelHeights while it processes one level
+typedef struct LevelJob_struct {
+    const FrozenWeb* pFw; // The snapshot being processed
+    int* height; // Height of each organism, set when it joins a frontier
+    int* preyLeft; // Prey of each organism not processed yet (updated atomically)
+    const int* frontier; // Organisms whose height is the current level
+    int frontierSize; // Number of organisms in frontier
+    int* next; // Organisms whose last prey was in this level
+    int nextSize; // Number of organisms in next (updated atomically)
+    int level; // Height of the current frontier
+} LevelJob;
+
+// Processes one chunk of the frontier: every predator whose last unprocessed prey is in the
+// chunk joins the next level. Found predators gather in a private buffer and are copied
+// into the shared next frontier with a single atomic reservation.
+void levelTask(void* ctx, int taskNum) {
+    LevelJob* pJob = (LevelJob*)ctx;
+    const FrozenWeb* pFw = pJob->pFw;
+    int from = taskNum * LEVEL_CHUNK;
+    int to = (from + LEVEL_CHUNK < pJob->frontierSize) ? from + LEVEL_CHUNK : pJob->frontierSize;
+    int* found = NULL;
+    int numFound = 0;
+    int capFound = 0;
+    for (int k = from; k < to; k++) {
+        int v = pJob->frontier[k];
+        for (int e = pFw->predStart[v]; e < pFw->predStart[v + 1]; e++) {
+            int pred = pFw->predIdx[e];
+            if (__atomic_sub_fetch(&(pJob->preyLeft[pred]), 1, __ATOMIC_ACQ_REL) == 0) {
+                pJob->height[pred] = pJob->level + 1;
+                appendInt(&found, &numFound, &capFound, pred);
+            }
+        }
+    }
+    if (numFound > 0) {
+        int at = __atomic_fetch_add(&(pJob->nextSize), numFound, __ATOMIC_RELAXED);
+        memcpy(&(pJob->next[at]), found, sizeof(int) * numFound);
+    }
+    free(found);
+}
+
+// Computes the height of every organism level by level, starting from the producers and
+// moving up the predator edges, with each level split across the pool. An organism's height
+// is the level at which its last prey was processed, which is one more than its tallest prey,
+// so the heights match computeHeights exactly. Returns false, leaving the heights unfinished,
+// if some organisms were never reached because they sit in or above a feeding cycle.
+bool levelHeights(const FrozenWeb* pFw, int* height, ThreadPool* pPool) {
+    int numOrg = pFw->numOrg;
+    int* preyLeft = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* frontier = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* next = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int frontierSize = 0;
+    for (int i = 0; i < numOrg; i++) {
+        preyLeft[i] = pFw->preyStart[i + 1] - pFw->preyStart[i];
+        if (preyLeft[i] == 0) {
+            height[i] = 0;
+            frontier[frontierSize++] = i;
+        }
+    }
+
+    LevelJob job;
+    job.pFw = pFw;
+    job.height = height;
+    job.preyLeft = preyLeft;
+    int numDone = 0;
+    for (int level = 0; frontierSize > 0; level++) {
+        numDone += frontierSize;
+        job.frontier = frontier;
+        job.frontierSize = frontierSize;
+        job.next = next;
+        job.nextSize = 0;
+        job.level = level;
+        runParallel(pPool, (frontierSize + LEVEL_CHUNK - 1) / LEVEL_CHUNK, levelTask, &job);
+        int* swap = frontier;
+        frontier = next;
+        next = swap;
+        frontierSize = job.nextSize;
+    }
+
+    free(preyLeft);
+    free(frontier);
+    free(next);
+    countStat(&(stats.edgesScanned), pFw->numRel);
+    return numDone == numOrg;
+}
+
+// Recomputes the cached heights and cycle ids from scratch in O(N+E) if an edit invalidated them.
+// Large webs are processed level by level across the pool; a web with feeding cycles falls
+// back to the sequential component pass, which is the only one that can report them.
+void refreshHeights(Web* pWeb, ThreadPool* pPool) {
+    if (pWeb->heightsValid) {
+        return;
+    }
+    FrozenWeb fw;
+    freezeWeb(pWeb, &fw);
+    int* height = (int*)malloc(sizeof(int) * (fw.numOrg + 1));
+    int* comp = (int*)malloc(sizeof(int) * (fw.numOrg + 1));
+    int numComp = 0;
+    if (pPool != NULL && fw.numRel >= LEVEL_MIN_RELATIONS && levelHeights(&fw, height, pPool)) {
+        // Without cycles every organism is a component of its own
+        for (int i = 0; i < fw.numOrg; i++) {
+            comp[i] = i;
+        }
+        numComp = fw.numOrg;
+    }
+    else {
+        numComp = computeHeights(&fw, height, comp);
+    }
+
+    for (int i = 0; i < fw.numOrg; i++) {
+        pWeb->orgs[fw.slots[i]].height = height[i];
+        pWeb->orgs[fw.slots[i]].cycle = comp[i];
+    }
+    pWeb->numCycleIds = numComp;
+    pWeb->hasCycles = (numComp < fw.numOrg);
+    pWeb->heightsValid = true;
+    free(height);
+    free(comp);
+    freeFrozenWeb(&fw);
+}
+
+// Finds and prints the height of each organism in the food web
+// (the cached heights must be current; displayAll refreshes them first)
+void heights(OutBuf* pOut, const Web* pWeb) {
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            outStr(pOut, "  ");
+            outStr(pOut, pWeb->orgs[slot].name);
+            outPrintf(pOut, ": %d\n", pWeb->orgs[slot].height);
+        }
+    }
+    if (!pWeb->hasCycles) {
+        return;
+    }
+
+    // Report every feeding cycle, listing its members in index order.
+    // Bucket the organisms by cycle id (a counting sort keeps index order in each bucket).
+    int numIds = pWeb->numCycleIds;
+    int* idStart = (int*)calloc(numIds + 1, sizeof(int));
+    int* members = (int*)malloc(sizeof(int) * (pWeb->numOrg + 1));
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            idStart[pWeb->orgs[slot].cycle + 1]++;
+        }
+    }
+    for (int c = 0; c < numIds; c++) {
+        idStart[c + 1] += idStart[c];
+    }
+    int* fill = (int*)malloc(sizeof(int) * (numIds + 1));
+    memcpy(fill, idStart, sizeof(int) * (numIds + 1));
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            members[fill[pWeb->orgs[slot].cycle]++] = slot;
+        }
+    }
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        const Org* pOrg = &(pWeb->orgs[slot]);
+        int c = pOrg->cycle;
+        // Skip organisms outside a cycle and cycles reported at an earlier member
+        if (pOrg->extinct || idStart[c + 1] - idStart[c] <= 1 || members[idStart[c]] != slot) {
+            continue;
+        }
+        outPrintf(pOut, "  Feeding cycle at height %d: %s", pOrg->height, pOrg->name);
+        for (int m = idStart[c] + 1; m < idStart[c + 1]; m++) {
+            outStr(pOut, ", ");
+            outStr(pOut, pWeb->orgs[members[m]].name);
+        }
+        outStr(pOut, "\n");
+    }
+    free(idStart);
+    free(members);
+    free(fill);
+}
+
+#define TROPHIC_CHUNK 4096 // Organisms per task of one height level
+#define TROPHIC_EXACT_MAX 256 // Largest feeding cycle solved exactly instead of by Jacobi sweeps
+#define TROPHIC_TOLERANCE 1e-9 // Jacobi sweeps stop once the estimated error is below this
+#define TROPHIC_MAX_SWEEPS 100000 // Jacobi sweeps allowed for the feeding cycles of one height
+
+// Struct to represent the shared state of refreshLevels while it processes one height
+typedef struct TrophicJob_struct {
+    const FrozenWeb* pFw; // The weighted snapshot being solved
+    const int* comp; // Component of each organism
+    const int* compStart; // Members of component c are compMembers[compStart[c]] .. [compStart[c + 1] - 1]
+    const int* compMembers; // Organisms grouped by component
+    double* level; // Trophic level of each organism, -1 if undefined
+    double* next; // Jacobi sweeps: the next iterate of each organism being solved
+    const int* members; // Organisms being solved one by one
+    int numMembers; // Number of organisms in members
+    bool jacobi; // Write the next iterate and its change instead of the final level
+    double* delta; // Jacobi sweeps: the largest change found by each task
+    const int* cycles; // Feeding cycles being solved exactly, one per task
+} TrophicJob;
+
+// Returns 1 + the weighted mean trophic level of an organism's prey (1 for a producer), or -1
+// if the level of one of its prey is undefined
+double levelFromPrey(const FrozenWeb* pFw, const double* level, int i) {
+    if (pFw->preyStart[i] == pFw->preyStart[i + 1]) {
+        return 1.0;
+    }
+    double sum = 0.0;
+    double total = 0.0;
+    for (int e = pFw->preyStart[i]; e < pFw->preyStart[i + 1]; e++) {
+        double preyLevel = level[pFw->preyIdx[e]];
+        if (preyLevel < 0.0) {
+            return -1.0;
+        }
+        sum += pFw->preyWeight[e] * preyLevel;
+        total += pFw->preyWeight[e];
+    }
+    return 1.0 + sum / total;
+}
+
+// Solves one chunk of the members: sets their levels, or in a Jacobi sweep computes their next
+// iterate from the current levels and records the largest change
+void trophicTask(void* ctx, int taskNum) {
+    TrophicJob* pJob = (TrophicJob*)ctx;
+    const FrozenWeb* pFw = pJob->pFw;
+    int from = taskNum * TROPHIC_CHUNK;
+    int to = (from + TROPHIC_CHUNK < pJob->numMembers) ? from + TROPHIC_CHUNK : pJob->numMembers;
+    double delta = 0.0;
+    long long scanned = 0;
+    for (int k = from; k < to; k++) {
+        int v = pJob->members[k];
+        double value = levelFromPrey(pFw, pJob->level, v);
+        scanned += pFw->preyStart[v + 1] - pFw->preyStart[v];
+        if (!pJob->jacobi) {
+            pJob->level[v] = value;
+            continue;
+        }
+        pJob->next[v] = value;
+        double change = (value > pJob->level[v]) ? value - pJob->level[v] : pJob->level[v] - value;
+        if (change > delta) {
+            delta = change;
+        }
+    }
+    if (pJob->jacobi) {
+        pJob->delta[taskNum] = delta;
+    }
+    countStat(&(stats.edgesScanned), scanned);
+}
+
+// Solves the levels of one small feeding cycle exactly. Each member v gives the equation
+// W(v) * TL(v) - sum of w * TL(p) over its prey p in the cycle = W(v) + sum of w * TL(p) over
+// its prey outside it, W(v) being its total weight; the system is diagonally dominant, so
+// Gaussian elimination with partial pivoting solves it stably in O(n^3) for n members.
+void exactCycleTask(void* ctx, int taskNum) {
+    TrophicJob* pJob = (TrophicJob*)ctx;
+    const FrozenWeb* pFw = pJob->pFw;
+    int c = pJob->cycles[taskNum];
+    const int* members = &(pJob->compMembers[pJob->compStart[c]]);
+    int n = pJob->compStart[c + 1] - pJob->compStart[c];
+    double* a = (double*)calloc((size_t)n * (n + 1), sizeof(double)); // Row r is a[r * (n + 1) ..], rhs last
+    bool defined = true;
+    long long scanned = 0;
+    for (int r = 0; r < n && defined; r++) {
+        int v = members[r];
+        double* row = &(a[(size_t)r * (n + 1)]);
+        for (int e = pFw->preyStart[v]; e < pFw->preyStart[v + 1]; e++) {
+            int prey = pFw->preyIdx[e];
+            double w = pFw->preyWeight[e];
+            row[r] += w;
+            row[n] += w;
+            if (pJob->comp[prey] != c) {
+                if (pJob->level[prey] < 0.0) { // Eating an undefined organism leaves the cycle undefined
+                    defined = false;
+                }
+                row[n] += w * pJob->level[prey];
+            }
+            else { // Members are numbered by their place in the cycle's member list
+                int col = 0;
+                while (members[col] != prey) {
+                    col++;
+                }
+                row[col] -= w;
+            }
+        }
+        scanned += pFw->preyStart[v + 1] - pFw->preyStart[v];
+    }
+
+    for (int k = 0; k < n && defined; k++) {
+        int pivot = k;
+        for (int r = k + 1; r < n; r++) {
+            if (a[(size_t)r * (n + 1) + k] * a[(size_t)r * (n + 1) + k] > a[(size_t)pivot * (n + 1) + k] * a[(size_t)pivot * (n + 1) + k]) {
+                pivot = r;
+            }
+        }
+        for (int j = k; j <= n; j++) {
+            double swap = a[(size_t)k * (n + 1) + j];
+            a[(size_t)k * (n + 1) + j] = a[(size_t)pivot * (n + 1) + j];
+            a[(size_t)pivot * (n + 1) + j] = swap;
+        }
+        for (int r = k + 1; r < n; r++) {
+            double factor = a[(size_t)r * (n + 1) + k] / a[(size_t)k * (n + 1) + k];
+            for (int j = k; j <= n; j++) {
+                a[(size_t)r * (n + 1) + j] -= factor * a[(size_t)k * (n + 1) + j];
+            }
+        }
+    }
+    for (int k = n - 1; k >= 0; k--) {
+        double sum = a[(size_t)k * (n + 1) + n];
+        for (int j = k + 1; j < n && defined; j++) {
+            sum -= a[(size_t)k * (n + 1) + j] * pJob->level[members[j]];
+        }
+        pJob->level[members[k]] = defined ? sum / a[(size_t)k * (n + 1) + k] : -1.0;
+    }
+    free(a);
+    countStat(&(stats.edgesScanned), scanned);
+}
+
+// Recomputes the flow-weighted trophic level of every organism of a weighted web if an edit
+// invalidated them: TL = 1 for a producer, else 1 + the weighted mean TL of its prey. That is
+// a sparse linear system over the whole web, solved here height by height (the cached heights
+// must be current): an organism outside a feeding cycle only eats lower heights, so one pass
+// over each height, split across the pool, gives its exact level in O(N+E) overall. Only the
+// members of a feeding cycle depend on each other. Small cycles are solved exactly, one per
+// task; large ones by parallel Jacobi sweeps, which converge because an open cycle takes in
+// energy from below. A cycle that eats nothing outside itself has no finite level, so it and
+// every organism that eats it (directly or not) are undefined (-1).
+void refreshLevels(Web* pWeb, ThreadPool* pPool) {
+    if (!pWeb->weighted || pWeb->levelsValid) {
+        return;
+    }
+    FrozenWeb fw;
+    freezeWeb(pWeb, &fw);
+    int numOrg = fw.numOrg;
+    int numIds = pWeb->numCycleIds;
+    int* height = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* comp = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int maxHeight = 0;
+    int i = 0;
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            height[i] = pWeb->orgs[slot].height;
+            comp[i] = pWeb->orgs[slot].cycle;
+            if (height[i] > maxHeight) {
+                maxHeight = height[i];
+            }
+            i++;
+        }
+    }
+
+    // Bucket the organisms by height and by component (counting sorts)
+    int* heightStart = (int*)calloc(maxHeight + 2, sizeof(int));
+    int* compStart = (int*)calloc(numIds + 2, sizeof(int));
+    for (i = 0; i < numOrg; i++) {
+        heightStart[height[i] + 1]++;
+        compStart[comp[i] + 1]++;
+    }
+    for (int h = 0; h <= maxHeight; h++) {
+        heightStart[h + 1] += heightStart[h];
+    }
+    for (int c = 0; c < numIds; c++) {
+        compStart[c + 1] += compStart[c];
+    }
+    int* byHeight = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* compMembers = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* fill = (int*)malloc(sizeof(int) * ((maxHeight > numIds ? maxHeight : numIds) + 2));
+    memcpy(fill, heightStart, sizeof(int) * (maxHeight + 2));
+    for (i = 0; i < numOrg; i++) {
+        byHeight[fill[height[i]]++] = i;
+    }
+    memcpy(fill, compStart, sizeof(int) * (numIds + 1));
+    for (i = 0; i < numOrg; i++) {
+        compMembers[fill[comp[i]]++] = i;
+    }
+
+    int* singles = (int*)malloc(sizeof(int) * (numOrg + 1)); // Organisms outside any cycle
+    int* solve = (int*)malloc(sizeof(int) * (numOrg + 1)); // Members of large open cycles
+    int* cycles = (int*)malloc(sizeof(int) * (numOrg + 1)); // Small open cycles
+    double* level = (double*)malloc(sizeof(double) * (numOrg + 1));
+    double* next = (double*)malloc(sizeof(double) * (numOrg + 1));
+    double* delta = (double*)malloc(sizeof(double) * ((numOrg + TROPHIC_CHUNK - 1) / TROPHIC_CHUNK + 1));
+    TrophicJob job;
+    job.pFw = &fw;
+    job.comp = comp;
+    job.compStart = compStart;
+    job.compMembers = compMembers;
+    job.level = level;
+    job.next = next;
+    job.delta = delta;
+    job.cycles = cycles;
+    for (int h = 0; h <= maxHeight; h++) {
+        int numSingles = 0;
+        int numSolve = 0;
+        int numCycles = 0;
+        for (int k = heightStart[h]; k < heightStart[h + 1]; k++) {
+            int v = byHeight[k];
+            int c = comp[v];
+            int size = compStart[c + 1] - compStart[c];
+            if (size == 1) {
+                singles[numSingles++] = v;
+                continue;
+            }
+            if (compMembers[compStart[c]] != v) {
+                continue; // Each cycle is set up once, at its first member
+            }
+            // A closed cycle is undefined; an open one is solved exactly or, if large, from 1 up
+            bool open = false;
+            for (int m = compStart[c]; m < compStart[c + 1] && !open; m++) {
+                int member = compMembers[m];
+                for (int e = fw.preyStart[member]; e < fw.preyStart[member + 1] && !open; e++) {
+                    open = (comp[fw.preyIdx[e]] != c);
+                }
+            }
+            if (open && size <= TROPHIC_EXACT_MAX) {
+                cycles[numCycles++] = c;
+                continue;
+            }
+            for (int m = compStart[c]; m < compStart[c + 1]; m++) {
+                level[compMembers[m]] = open ? 1.0 : -1.0;
+                if (open) {
+                    solve[numSolve++] = compMembers[m];
+                }
+            }
+        }
+        job.members = singles;
+        job.numMembers = numSingles;
+        job.jacobi = false;
+        runParallel(pPool, (numSingles + TROPHIC_CHUNK - 1) / TROPHIC_CHUNK, trophicTask, &job);
+        runParallel(pPool, numCycles, exactCycleTask, &job);
+
+        // Jacobi sweeps shrink the error by a steady ratio, so stop once the change of one sweep
+        // times ratio / (1 - ratio), a bound on the error left, is within the tolerance
+        job.members = solve;
+        job.numMembers = numSolve;
+        job.jacobi = true;
+        int numTasks = (numSolve + TROPHIC_CHUNK - 1) / TROPHIC_CHUNK;
+        double lastDelta = 0.0;
+        for (int sweep = 0; sweep < TROPHIC_MAX_SWEEPS && numSolve > 0; sweep++) {
+            runParallel(pPool, numTasks, trophicTask, &job);
+            double maxDelta = 0.0;
+            for (int t = 0; t < numTasks; t++) {
+                if (delta[t] > maxDelta) {
+                    maxDelta = delta[t];
+                }
+            }
+            for (int k = 0; k < numSolve; k++) {
+                level[solve[k]] = next[solve[k]];
+            }
+            double ratio = (lastDelta > 0.0) ? maxDelta / lastDelta : 1.0;
+            if (maxDelta == 0.0 || (ratio < 1.0 && maxDelta * ratio / (1.0 - ratio) < TROPHIC_TOLERANCE)) {
+                break;
+            }
+            lastDelta = maxDelta;
+        }
+    }
+
+    pWeb->levels = (double*)realloc(pWeb->levels, sizeof(double) * (pWeb->numSlots + 1));
+    for (i = 0; i < numOrg; i++) {
+        pWeb->levels[fw.slots[i]] = level[i];
+    }
+    pWeb->levelsValid = true;
+    free(height);
+    free(comp);
+    free(heightStart);
+    free(compStart);
+    free(byHeight);
+    free(compMembers);
+    free(fill);
+    free(singles);
+    free(solve);
+    free(cycles);
+    free(level);
+    free(next);
+    free(delta);
+    freeFrozenWeb(&fw);
+}
+
+// Finds and prints the flow-weighted trophic level of each organism in a weighted food web
+// (the cached levels must be current; displayAll refreshes them first)
+void trophicLevels(OutBuf* pOut, const Web* pWeb) {
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        if (!pWeb->orgs[slot].extinct) {
+            outStr(pOut, "  ");
+            outStr(pOut, pWeb->orgs[slot].name);
+            if (pWeb->levels[slot] < 0.0) {
+                outStr(pOut, ": undefined\n");
+            }
+            else {
+                outPrintf(pOut, ": %.4f\n", pWeb->levels[slot]);
+            }
+        }
+    }
+}
+
+void voreType(OutBuf* pOut, const Web* pWeb) {
+    // One classification pass tagged every organism, so each list is a scan of one byte per slot
+    outStr(pOut, "  Producers:\n");
+    printTagged(pOut, pWeb, "    ", TAG_PRODUCER);
+    outStr(pOut, "  Herbivores:\n");
+    printTagged(pOut, pWeb, "    ", TAG_HERBIVORE);
+    outStr(pOut, "  Omnivores:\n");
+    printTagged(pOut, pWeb, "    ", TAG_OMNIVORE);
+    outStr(pOut, "  Carnivores:\n");
+    printTagged(pOut, pWeb, "    ", TAG_CARNIVORE);
+
+}
+
+#define CLASSIFY_CHUNK 65536 // Slots per task of the parallel classification
+
+// Runs classifyRange over one chunk of the slots
+void classifyTask(void* ctx, int taskNum) {
+    Web* pWeb = (Web*)ctx;
+    int from = taskNum * CLASSIFY_CHUNK;
+    int to = (from + CLASSIFY_CHUNK < pWeb->numSlots) ? from + CLASSIFY_CHUNK : pWeb->numSlots;
+    classifyRange(pWeb->slotPrey, pWeb->slotBasal, pWeb->slotPred, pWeb->slotLive, pWeb->tags, from, to, pWeb->maxPrey, pWeb->maxPred);
+}
+
+// Tags every organism in one pass, split into chunks across the pool for large webs
+void classifyOrgs(Web* pWeb, ThreadPool* pPool) {
+    if (pWeb->tagsValid) {
+        return;
+    }
+    int numChunks = (pWeb->numSlots + CLASSIFY_CHUNK - 1) / CLASSIFY_CHUNK;
+    runParallel(pPool, numChunks, classifyTask, pWeb);
+    pWeb->tagsValid = true;
+}
+
+#define KNOCKOUT_TASKS_PER_THREAD 4 // Knockout tasks per pool thread, to even out uneven cascades
+
+// Struct to represent one knockout sweep: every organism is removed in turn from a read-only
+// snapshot and the secondary extinctions of each removal are counted
+typedef struct KnockoutJob_struct {
+    const FrozenWeb* pFw; // The snapshot every knockout starts from
+    int numTasks; // Number of tasks the organisms are split into
+    int* lost; // Secondary extinctions caused by removing each organism
+} KnockoutJob;
+
+// Runs the knockouts of one share of the organisms. Each task simulates on its own overlay
+// of per-organism prey counts instead of a copy of the web: an entry only counts once its
+// stamp equals the current knockout's epoch, so starting the next knockout is O(1) and each
+// one costs O(affected edges), like cascadeExtinction.
+void knockoutTask(void* ctx, int taskNum) {
+    KnockoutJob* pJob = (KnockoutJob*)ctx;
+    const FrozenWeb* pFw = pJob->pFw;
+    int numOrg = pFw->numOrg;
+    int* preyLeft = (int*)malloc(sizeof(int) * (numOrg + 1)); // Prey left, 0 once dead
+    unsigned* stamp = (unsigned*)calloc(numOrg + 1, sizeof(unsigned)); // Epoch of each entry
+    int* work = (int*)malloc(sizeof(int) * (numOrg + 1)); // Organisms that died, in order
+    unsigned epoch = 0;
+
+    for (int i = taskNum; i < numOrg; i += pJob->numTasks) {
+        epoch++;
+        int numWork = 0;
+        stamp[i] = epoch;
+        preyLeft[i] = 0;
+        work[numWork++] = i;
+        for (int w = 0; w < numWork; w++) {
+            int v = work[w];
+            for (int e = pFw->predStart[v]; e < pFw->predStart[v + 1]; e++) {
+                int pred = pFw->predIdx[e];
+                if (stamp[pred] != epoch) {
+                    stamp[pred] = epoch;
+                    preyLeft[pred] = pFw->preyStart[pred + 1] - pFw->preyStart[pred];
+                }
+                // Every predator still alive has prey left, so this only kills it once
+                if (preyLeft[pred] > 0 && --preyLeft[pred] == 0) {
+                    work[numWork++] = pred;
+                }
+            }
+        }
+        pJob->lost[i] = numWork - 1;
+    }
+
+    free(preyLeft);
+    free(stamp);
+    free(work);
+}
+
+// Removes each organism in turn, across the pool, and prints the organisms ranked by how
+// many secondary extinctions their removal causes (ties in index order). The web is not changed.
+void knockoutSweep(OutBuf* pOut, const Web* pWeb, ThreadPool* pPool) {
+    FrozenWeb fw;
+    freezeWeb(pWeb, &fw);
+    KnockoutJob job;
+    job.pFw = &fw;
+    job.numTasks = (pPool == NULL) ? 1 : (pPool->numWorkers + 1) * KNOCKOUT_TASKS_PER_THREAD;
+    if (job.numTasks > fw.numOrg) {
+        job.numTasks = (fw.numOrg > 0) ? fw.numOrg : 1;
+    }
+    job.lost = (int*)malloc(sizeof(int) * (fw.numOrg + 1));
+    runParallel(pPool, job.numTasks, knockoutTask, &job);
+
+    // Rank with a counting sort on the extinction counts, largest first, which keeps index order
+    int* countStart = (int*)calloc(fw.numOrg + 1, sizeof(int));
+    int* ranked = (int*)malloc(sizeof(int) * (fw.numOrg + 1));
+    for (int i = 0; i < fw.numOrg; i++) {
+        countStart[fw.numOrg - 1 - job.lost[i]]++;
+    }
+    for (int c = 0, sum = 0; c < fw.numOrg; c++) {
+        int num = countStart[c];
+        countStart[c] = sum;
+        sum += num;
+    }
+    for (int i = 0; i < fw.numOrg; i++) {
+        ranked[countStart[fw.numOrg - 1 - job.lost[i]]++] = i;
+    }
+
+    outStr(pOut, "  Rank  Lost  Organism\n");
+    for (int r = 0; r < fw.numOrg; r++) {
+        int i = ranked[r];
+        outPrintf(pOut, "  %4d  %4d  %s\n", r + 1, job.lost[i], fw.names[i]);
+    }
+    free(countStart);
+    free(ranked);
+    free(job.lost);
+    freeFrozenWeb(&fw);
+}
+
+#define REACH_BITS_MAX 16384 // Most components whose dependency rows are kept as bits (32 MiB)
+
+// Rebuilds the reachability index behind dependency queries in O(N+E) if an edit invalidated
+// it (the pending extinctions must be applied). The feeding cycles are condensed with the
+// Tarjan pass of computeHeights, which numbers every component after all those it eats, so
+// walking the components in order sees each one's prey first. Each component gets the lowest
+// component it depends on: since that numbering is a post-order, a component can only depend
+// on components numbered in [low, itself] and of lower height, which rules most pairs out in
+// O(1). Webs with up to REACH_BITS_MAX components also keep the full transitive closure as one
+// bit row per component, so every query is O(1); a prey component already in a row is skipped,
+// since its own row is then in there too.
+void refreshReach(Web* pWeb) {
+    if (pWeb->reachValid) {
+        return;
+    }
+    double start = startPhase();
+    FrozenWeb fw;
+    freezeWeb(pWeb, &fw);
+    int numOrg = fw.numOrg;
+    int* height = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int* comp = (int*)malloc(sizeof(int) * (numOrg + 1));
+    int numComp = computeHeights(&fw, height, comp);
+    free(pWeb->reachHeight);
+    pWeb->reachHeight = (int*)malloc(sizeof(int) * (numComp + 1));
+    for (int i = 0; i < numOrg; i++) {
+        pWeb->reachHeight[comp[i]] = height[i];
+    }
+    free(height);
+
+    // Group the organisms by component with a counting sort
+    int* memberStart = (int*)calloc(numComp + 1, sizeof(int));
+    int* members = (int*)malloc(sizeof(int) * (numOrg + 1));
+    for (int i = 0; i < numOrg; i++) {
+        memberStart[comp[i] + 1]++;
+    }
+    for (int c = 0; c < numComp; c++) {
+        memberStart[c + 1] += memberStart[c];
+    }
+    for (int i = 0; i < numOrg; i++) {
+        members[memberStart[comp[i]]++] = i;
+    }
+    for (int c = numComp; c > 0; c--) {
+        memberStart[c] = memberStart[c - 1];
+    }
+    memberStart[0] = 0;
+
+    free(pWeb->reachLow);
+    free(pWeb->reachBits);
+    pWeb->reachLow = (int*)malloc(sizeof(int) * (numComp + 1));
+    pWeb->reachBits = NULL;
+    pWeb->reachWords = (numComp + 63) / 64;
+    if (numComp <= REACH_BITS_MAX) {
+        pWeb->reachBits = (unsigned long long*)calloc((size_t)numComp * pWeb->reachWords + 1, sizeof(unsigned long long));
+        countStat(&(stats.allocations), 1);
+    }
+    for (int c = 0; c < numComp; c++) {
+        int low = c;
+        unsigned long long* row = (pWeb->reachBits != NULL) ? &(pWeb->reachBits[(size_t)c * pWeb->reachWords]) : NULL;
+        for (int m = memberStart[c]; m < memberStart[c + 1]; m++) {
+            int member = members[m];
+            for (int e = fw.preyStart[member]; e < fw.preyStart[member + 1]; e++) {
+                int d = comp[fw.preyIdx[e]];
+                if (d != c && pWeb->reachLow[d] < low) {
+                    low = pWeb->reachLow[d];
+                }
+                if (row == NULL || (row[d / 64] >> (d % 64)) & 1ULL) {
+                    continue;
+                }
+                row[d / 64] |= 1ULL << (d % 64); // d == c inside a feeding cycle: c depends on itself
+                if (d != c) {
+                    const unsigned long long* preyRow = &(pWeb->reachBits[(size_t)d * pWeb->reachWords]);
+                    for (int w = 0; w <= d / 64; w++) { // Components above d are not in its row
+                        row[w] |= preyRow[w];
+                    }
+                }
+            }
+        }
+        pWeb->reachLow[c] = low;
+    }
+    countStat(&(stats.edgesScanned), fw.numRel);
+
+    free(pWeb->reachComp);
+    free(pWeb->reachParent);
+    free(pWeb->reachQueue);
+    pWeb->reachComp = (int*)malloc(sizeof(int) * (pWeb->numSlots + 1));
+    pWeb->reachParent = (int*)calloc(pWeb->numSlots + 1, sizeof(int));
+    pWeb->reachQueue = (int*)malloc(sizeof(int) * (pWeb->numSlots + 1));
+    for (int slot = 0; slot < pWeb->numSlots; slot++) {
+        pWeb->reachComp[slot] = -1;
+    }
+    for (int i = 0; i < fw.numOrg; i++) {
+        pWeb->reachComp[fw.slots[i]] = comp[i];
+    }
+    pWeb->reachValid = true;
+    free(comp);
+    free(memberStart);
+    free(members);
+    freeFrozenWeb(&fw);
+    endPhase(PHASE_REACH, start);
+}
+
+// Returns false if component from certainly does not depend on component to. With the bit
+// rows the answer is exact; otherwise true only means the labels and heights allow it.
+bool mayDependOn(const Web* pWeb, int from, int to) {
+    if (pWeb->reachBits != NULL) {
+        return (pWeb->reachBits[(size_t)from * pWeb->reachWords + to / 64] >> (to % 64)) & 1ULL;
+    }
+    if (to == from) {
+        return true;
+    }
+    return to < from && pWeb->reachLow[from] <= pWeb->reachLow[to] && pWeb->reachHeight[to] < pWeb->reachHeight[from];
+}
+
+// Finds a shortest food chain from the organism in preySlot up to the one in predSlot with a
+// breadth-first search down the prey lists of predSlot that never enters an organism the index
+// rules out. Returns the number of links, or -1 if predSlot does not depend on preySlot. If
+// pChain is not NULL it receives the slots of the chain in the order energy flows, prey first.
+// The index must be current; the search costs O(organisms and relations it reaches).
+int shortestChain(Web* pWeb, int predSlot, int preySlot, int** pChain) {
+    int target = pWeb->reachComp[preySlot];
+    if (!mayDependOn(pWeb, pWeb->reachComp[predSlot], target)) {
+        return -1;
+    }
+    int* parent = pWeb->reachParent;
+    int* queue = pWeb->reachQueue;
+    int head = 0;
+    int tail = 0;
+    parent[predSlot] = predSlot + 1;
+    queue[tail++] = predSlot;
+    long long scanned = 0;
+    while (head < tail && parent[preySlot] == 0) {
+        const Org* pOrg = &(pWeb->orgs[queue[head]]);
+        scanned += pOrg->numPrey;
+        for (int j = 0; j < pOrg->numPrey; j++) {
+            int prey = pOrg->prey[j];
+            if (parent[prey] != 0 || (prey != preySlot && !mayDependOn(pWeb, pWeb->reachComp[prey], target))) {
+                continue;
+            }
+            parent[prey] = queue[head] + 1;
+            queue[tail++] = prey;
+        }
+        head++;
+    }
+    countStat(&(stats.edgesScanned), scanned);
+
+    int numLinks = -1;
+    if (parent[preySlot] != 0) {
+        numLinks = 0;
+        for (int slot = preySlot; slot != predSlot; slot = parent[slot] - 1) {
+            numLinks++;
+        }
+        if (pChain != NULL) { // Walking the parents from the prey goes up the chain
+            int* chain = (int*)malloc(sizeof(int) * (numLinks + 1));
+            int k = 0;
+            for (int slot = preySlot; slot != predSlot; slot = parent[slot] - 1) {
+                chain[k++] = slot;
+            }
+            chain[k] = predSlot;
+            *pChain = chain;
+        }
+    }
+    for (int k = 0; k < tail; k++) { // Clear only what this search touched
+        parent[queue[k]] = 0;
+    }
+    return numLinks;
+}
+
+// Returns true if the organism in predSlot eats the one in preySlot, directly or through other
+// organisms. O(1) with the bit rows; otherwise the search is confined to what the labels allow.
+// The index must be current.
+bool dependsOn(Web* pWeb, int predSlot, int preySlot) {
+    if (pWeb->reachBits != NULL) {
+        return mayDependOn(pWeb, pWeb->reachComp[predSlot], pWeb->reachComp[preySlot]);
+    }
+    return shortestChain(pWeb, predSlot, preySlot, NULL) >= 0;
+}
+
+// Answers a dependency query: whether the organism at predInd depends on the one at preyInd,
+// and if so the shortest food chain between them. The pending extinctions must be applied.
+void dependencyQuery(OutBuf* pOut, Web* pWeb, int predInd, int preyInd) {
+    if (!(predInd >= 0 && preyInd >= 0 && predInd < pWeb->numOrg && preyInd < pWeb->numOrg && predInd != preyInd)) {
+        outStr(pOut, "Invalid indices for dependency query\n");
+        return;
+    }
+    refreshReach(pWeb);
+    int predSlot = slotOfIndex(pWeb, predInd);
+    int preySlot = slotOfIndex(pWeb, preyInd);
+    const char* predName = pWeb->orgs[predSlot].name;
+    const char* preyName = pWeb->orgs[preySlot].name;
+    outPrintf(pOut, "Dependency Query: %s on %s\n", predName, preyName);
+    if (!dependsOn(pWeb, predSlot, preySlot)) {
+        outPrintf(pOut, "  %s does not depend on %s\n", predName, preyName);
+        return;
+    }
+    int* chain = NULL;
+    int numLinks = shortestChain(pWeb, predSlot, preySlot, &chain);
+    outPrintf(pOut, "  %s depends on %s\n", predName, preyName);
+    outPrintf(pOut, "  Shortest food chain (%d link%s): ", numLinks, (numLinks == 1) ? "" : "s");
+    for (int k = 0; k <= numLinks; k++) {
+        outStr(pOut, pWeb->orgs[chain[k]].name);
+        outStr(pOut, (k < numLinks) ? " -> " : "\n");
+    }
+    free(chain);
+}
+
+// Struct to represent one section of displayAll: a heading and the function that prints it
+typedef struct Section_struct {
+    const char* title; // Heading printed above the section
+    void (*print)(OutBuf* pOut, const Web* pWeb); // Prints the body of the section
+    bool weightedOnly; // Only printed for a weighted web
+} Section;
+
+// The sections of displayAll in the order they are printed
+const Section displaySections[NUM_SECTIONS] = {
+    {"Food Web Predators & Prey:\n", printWeb, false},
+    {"Apex Predators:\n", apexPredators, false},
+    {"Producers:\n", producers, false},
+    {"Most Flexible Eaters:\n", mostFlexibleEaters, false},
+    {"Tastiest Food:\n", tastiestFood, false},
+    {"Food Web Heights:\n", heights, false},
+    {"Trophic Levels:\n", trophicLevels, true},
+    {"Vore Types:\n", voreType, false},
+};
+
+// Struct to represent the shared argument of the parallel displayAll job
+typedef struct SectionJob_struct {
+    const Web* pWeb; // The web every section reads
+    OutBuf* sectionOut; // One memory-only buffer per section
+} SectionJob;
+
+// Prints one section of displayAll into its own buffer
+void printSectionTask(void* ctx, int taskNum) {
+    SectionJob* pJob = (SectionJob*)ctx;
+    if (displaySections[taskNum].weightedOnly && !pJob->pWeb->weighted) {
+        return;
+    }
+    double start = startPhase();
+    displaySections[taskNum].print(&(pJob->sectionOut[taskNum]), pJob->pWeb);
+    endPhase(PHASE_SECTION + taskNum, start);
+}
+
+// Displays every characteristic of the web. With a thread pool the sections, which only read
+// the web, are printed concurrently into separate buffers and then emitted in the usual order,
+// so the output is the same either way.
+void displayAll(OutBuf* pOut, Web* pWeb, bool modified, ThreadPool* pPool) {
+    // Apply any batched edits and bring the cached heights and tags up to date first, so every
+    // section only reads the web
+    applyPending(pWeb);
+    double start = startPhase();
+    refreshHeights(pWeb, pPool);
+    endPhase(PHASE_HEIGHTS, start);
+    start = startPhase();
+    classifyOrgs(pWeb, pPool);
+    endPhase(PHASE_CLASSIFY, start);
+    if (pWeb->weighted) {
+        start = startPhase();
+        refreshLevels(pWeb, pPool);
+        endPhase(PHASE_LEVELS, start);
+    }
+
+    OutBuf sectionOut[NUM_SECTIONS];
+    if (pPool != NULL) {
+        SectionJob job;
+        job.pWeb = pWeb;
+        job.sectionOut = sectionOut;
+        for (int k = 0; k < NUM_SECTIONS; k++) {
+            initOut(&(sectionOut[k]), NULL);
+        }
+        runParallel(pPool, NUM_SECTIONS, printSectionTask, &job);
+    }
+
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        if (displaySections[k].weightedOnly && !pWeb->weighted) {
+            if (pPool != NULL) {
+                freeOut(&(sectionOut[k]));
+            }
+            continue;
+        }
+        if (modified) outStr(pOut, "UPDATED ");
+        outStr(pOut, displaySections[k].title);
+        if (pPool != NULL) {
+            outBytes(pOut, sectionOut[k].data, sectionOut[k].len);
+            freeOut(&(sectionOut[k]));
+        }
+        else {
+            start = startPhase();
+            displaySections[k].print(pOut, pWeb);
+            endPhase(PHASE_SECTION + k, start);
+        }
+        outStr(pOut, "\n");
+    }
 }
 
-// Removes an organism from the food web and updates relationships
-bool removeOrgFromWeb(Org** ppWeb, int* pNumOrg, int index) {
-    // Check if the index is valid
-    if (index < 0 || index >= *pNumOrg) {
-      printf("Invalid extinction index. No organism removed from the food web.");
-      return false;
+// Prints the phase timers and the counters of timing mode
+void printStats(OutBuf* pOut) {
+    const char* phaseNames[PHASE_SECTION] = {
+        "Reading organisms", "Reading relations", "Snapshot", "Modification loop", "Heights", "Classification",
+        "Solving trophic levels", "Journal and checkpoints", "Reachability index"
+    };
+    outStr(pOut, "Timing and counters:\n");
+    outPrintf(pOut, "  %-28s %10s %12s\n", "Phase", "Calls", "Seconds");
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        if (phase < PHASE_SECTION) {
+            outPrintf(pOut, "  %-28s", phaseNames[phase]);
+        }
+        else { // The section's title without the colon and newline
+            const char* title = displaySections[phase - PHASE_SECTION].title;
+            outPrintf(pOut, "  %-28.*s", (int)strlen(title) - 2, title);
+        }
+        outPrintf(pOut, " %10lld %12.6f\n", stats.calls[phase], stats.seconds[phase]);
     }
-    free((*ppWeb)[index].prey); // Free prey array of the organism to be removed
+    outPrintf(pOut, "  Allocations: %lld\n", stats.allocations);
+    outPrintf(pOut, "  Bytes copied: %lld\n", stats.bytesCopied);
+    outPrintf(pOut, "  Edges scanned: %lld\n", stats.edgesScanned);
+}
 
-    // Case where only one organism remains
-    if (*pNumOrg == 1) {
-        free((*ppWeb)[index].prey);
-        (*pNumOrg)--;
-        free(*ppWeb); // Free the main organism array
-        *ppWeb = NULL; // Set pointer to NULL as no organisms remain
-        return true;
-    }
-    // Create a new array with one fewer organism
-    Org* newWeb = (Org*)malloc((*pNumOrg - 1) * sizeof(Org));
+// Struct to represent where user input comes from. Interactive runs read stdin with scanf;
+// bulk mode takes the whole input up front (memory-mapped when stdin is a regular file,
+// block-read otherwise) and tokenizes it by hand with no per-token libc call.
+typedef struct Input_struct {
+    bool bulk; // Read from the buffer below instead of scanf
+    char* data; // Whole input in bulk mode
+    size_t len; // Number of bytes in data
+    size_t pos; // Next byte to read
+    bool mapped; // data is an mmap of stdin rather than a malloc'd buffer
+    OutBuf* pPrompt; // Output flushed before each interactive read so the prompt shows, or NULL
+} Input;
 
-    // Copy all organisms except the one to be removed
-    for (int i = 0; i < index; i++) {
-        newWeb[i] = (*ppWeb)[i];
-    }
-    for (int j = index + 1; j < *pNumOrg; j++) {
-        newWeb[j - 1] = (*ppWeb)[j];
-    }
-    
-    free(*ppWeb);
-    *ppWeb = newWeb;
-    (*pNumOrg)--;
-
-    int* preyArr = NULL;
-    // Update prey relationships to remove references to the extinct organism
-    for (int i = 0; i < *pNumOrg; i++) {
-        for (int j = 0; j < (*ppWeb)[i].numPrey; j++) {
-            if ((*ppWeb)[i].prey[j] == index) { // If prey is the extinct organism
-                if ((*ppWeb)[i].numPrey == 1) {
-                    // Adjust the prey array
-                    free((*ppWeb)[i].prey);
-                    (*ppWeb)[i].prey = NULL;
-                    (*ppWeb)[i].numPrey--;
-                }
-                else if ((*ppWeb)[i].numPrey != 1) {
-                    preyArr = (int*)malloc(sizeof(int) * ((*ppWeb)[i].numPrey - 1));
-                    for (int k = 0; k < j; k++) {
-                        preyArr[k] = (*ppWeb)[i].prey[k];
-                    }
-                    for (int l = j + 1; l < (*ppWeb)[i].numPrey; l++) {
-                        preyArr[l - 1] = (*ppWeb)[i].prey[l];
-                    }
-                    free((*ppWeb)[i].prey);
-                    (*ppWeb)[i].prey = preyArr;
-                    (*ppWeb)[i].numPrey = (*ppWeb)[i].numPrey - 1;
-                }
-            }
-        }  
+// Takes the whole of fd into the bulk input buffer: memory-mapped when it is a regular file,
+// block-read otherwise
+void readAllInput(Input* pIn, int fd) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            pIn->data = (char*)map;
+            pIn->len = info.st_size;
+            pIn->mapped = true;
+            return;
+        }
     }
 
-    // Adjust prey indices after the removal
-    for (int m = 0; m < *pNumOrg; m++) {
-        for (int n = 0; n < (*ppWeb)[m].numPrey; n++) {
-            if ((*ppWeb)[m].prey[n] > index) {
-                (*ppWeb)[m].prey[n]--;
-            }
+    // Pipes and terminals cannot be mapped, so read them in large blocks instead
+    size_t cap = 1 << 16;
+    pIn->data = (char*)malloc(cap);
+    ssize_t got;
+    while ((got = read(fd, pIn->data + pIn->len, cap - pIn->len)) > 0) {
+        pIn->len += got;
+        if (pIn->len == cap) {
+            cap *= 2;
+            pIn->data = (char*)realloc(pIn->data, cap);
         }
-    } 
+    }
+}
 
-    return true;
-   
+// Opens the program input; in bulk mode all of stdin is taken into memory at once.
+// pPrompt is the output to flush before each interactive read (NULL when nobody is prompted).
+void openInput(Input* pIn, bool bulk, OutBuf* pPrompt) {
+    pIn->bulk = bulk;
+    pIn->pPrompt = bulk ? NULL : pPrompt;
+    pIn->data = NULL;
+    pIn->len = 0;
+    pIn->pos = 0;
+    pIn->mapped = false;
+    if (bulk) {
+        readAllInput(pIn, STDIN_FILENO);
+    }
 }
 
-// Prints the food web with organism names and their prey
-void printWeb(Org* pWeb, int numOrg) {
-    for (int i = 0; i < numOrg; i++) {
-        printf("  (%d) %s", i, pWeb[i].name);
-        if (pWeb[i].numPrey > 0) {
-            printf(" eats ");
-            for (int j = 0; j < pWeb[i].numPrey; j++) {
-                if (j != (pWeb[i].numPrey - 1)) {
-                    printf("%s, ", pWeb[pWeb[i].prey[j]].name);
-                }
-                else {
-                    printf("%s", pWeb[pWeb[i].prey[j]].name);
-                }
-            }
-        }
-        printf("\n");
+// Opens a file as bulk input, as if it had been redirected to stdin with -l.
+// Returns false if the file cannot be opened.
+bool openInputFile(Input* pIn, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
     }
+    openInput(pIn, false, NULL);
+    pIn->bulk = true;
+    readAllInput(pIn, fd);
+    close(fd); // A mapping stays valid after its file is closed
+    return true;
 }
 
-// Finds and prints apex predators 
-void apexPredators(Org *pWeb, int numOrg) {
-    for (int i = 0; i < numOrg; i++) {
-        bool found = false; // Check if the organism is preyed upon
-        for (int j = 0; j < numOrg; j++) {
-            for (int k = 0; k < pWeb[j].numPrey; k++) {
-                if (pWeb[j].prey[k] == i) {
-                    found = true; // Check if the organism is preyed upon
-                    break;
-                }
-            }
-            if (found) { // Stop searching if the organism is preyed upon
-                break;
-            }
-        }
-        if (!found) {
-            printf("  %s\n", pWeb[i].name);
-        }
+// Releases the bulk input buffer
+void closeInput(Input* pIn) {
+    if (pIn->mapped) {
+        munmap(pIn->data, pIn->len);
+    }
+    else {
+        free(pIn->data);
     }
+    pIn->data = NULL;
+    pIn->len = 0;
 }
 
-// Finds and prints all producers
-void producers(Org *pWeb, int numOrg) {
-    for (int i = 0; i < numOrg; i++) {
-        if (pWeb[i].numPrey == 0) {
-            printf("  %s\n", pWeb[i].name);
-        }
+// Returns true for the characters scanf treats as white space
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Skips white space in the bulk buffer; returns false at the end of the input
+bool skipSpace(Input* pIn) {
+    while (pIn->pos < pIn->len && isSpace(pIn->data[pIn->pos])) {
+        pIn->pos++;
     }
+    return pIn->pos < pIn->len;
 }
 
-// Finds and prints the most flexible eaters
-void mostFlexibleEaters(Org *pWeb, int numOrg) {
-    int flexEaters = 0;
-    for (int i = 0; i < numOrg; i++) {
-        if (flexEaters < pWeb[i].numPrey) {
-            flexEaters = pWeb[i].numPrey;
+// Reads one white-space separated word (like "%s") into a buffer of MAX_NAME_LEN + 1 characters;
+// anything past MAX_NAME_LEN characters is dropped
+bool readWord(Input* pIn, char* word) {
+    if (!pIn->bulk) {
+        if (pIn->pPrompt != NULL) {
+            flushOut(pIn->pPrompt);
         }
+        return scanf("%" XSTR(MAX_NAME_LEN) "s%*[^ \t\n\r\v\f]", word) == 1;
     }
-    for (int i = 0; i < numOrg; i++) {
-        if (pWeb[i].numPrey == flexEaters) {
-            printf("  %s\n", pWeb[i].name);
+    if (!skipSpace(pIn)) {
+        return false;
+    }
+    int n = 0;
+    while (pIn->pos < pIn->len && !isSpace(pIn->data[pIn->pos])) {
+        if (n < MAX_NAME_LEN) {
+            word[n++] = pIn->data[pIn->pos];
         }
+        pIn->pos++;
     }
+    word[n] = '\0';
+    return true;
 }
 
-// Finds and prints the most tasty organism 
-void tastiestFood(Org *pWeb, int numOrg) {
-    int foodCount[numOrg]; // Array to count how many times each organism is prey
-    for (int i = 0; i < numOrg; i++) {
-        foodCount[i] = 0;
+// Parses a whole word as a decimal integer; returns false if it is not one or does not fit
+// in an int, so an overlong number reads as invalid input
+bool parseInt(const char* word, int* pValue) {
+    const char* c = word;
+    bool negative = false;
+    if (*c == '-' || *c == '+') {
+        negative = (*c == '-');
+        c++;
     }
-    for (int i = 0; i < numOrg; i++) {
-        for (int j = 0; j < pWeb[i].numPrey; j++) {
-            foodCount[pWeb[i].prey[j]]++;
-        }
+    if (*c == '\0') { // A sign with no digits is not a number
+        return false;
     }
-    int maxEaten = 0;
-    for (int i = 0; i < numOrg; i++) {
-        if (foodCount[i] > maxEaten) { // Find the organism that is eaten the most
-            maxEaten = foodCount[i];
+    int value = 0;
+    for (; *c != '\0'; c++) {
+        if (*c < '0' || *c > '9') {
+            return false;
         }
-    }
-    for (int i = 0; i < numOrg; i++) {
-        if (foodCount[i] == maxEaten) {
-            printf("  %s\n", pWeb[i].name);
+        int digit = *c - '0';
+        if (value > (INT_MAX - digit) / 10) {
+            return false;
         }
+        value = value * 10 + digit;
     }
+    *pValue = negative ? -value : value;
+    return true;
 }
 
-// Finds and prints the height of each organism in the food web
-void heights(Org *pWeb, int numOrg) {
-    int height[numOrg];
-    for (int i = 0; i < numOrg; i++) {
-        height[i] = 0;
+// Reads an organism given either by index or by name. A name is looked up in the web's
+// name table, so callers need not track how indices shift; an unknown name gives -1.
+bool readIndex(Input* pIn, const Web* pWeb, int* pIndex) {
+    char word[MAX_NAME_LEN + 1];
+    if (!readWord(pIn, word)) {
+        return false;
+    }
+    if (!parseInt(word, pIndex)) {
+        *pIndex = indexOfName(pWeb, word);
     }
+    return true;
+}
 
-    bool go = true;
+// Reads the weight that follows a relation in weighted mode. A missing or malformed weight
+// reads as 0, which addWeightedRelationToWeb rejects.
+double readWeight(Input* pIn) {
+    char word[MAX_NAME_LEN + 1];
+    if (!readWord(pIn, word)) {
+        return 0.0;
+    }
+    char* end;
+    double weight = strtod(word, &end);
+    return (end != word && *end == '\0') ? weight : 0.0;
+}
 
-    // Loop until no more height updates are needed
-    while(go) {
-        go = false;
-        for (int i = 0; i < numOrg; i++) {
-            int heights = 0;
-            for (int j = 0; j < pWeb[i].numPrey; j++) {
-                int preyIdx = pWeb[i].prey[j];
-                if (height[preyIdx] + 1 > heights) {
-                    heights = height[preyIdx] + 1;
-                }
-            }
-    
-            if (height[i] < heights) {
-                height[i] = heights;
-                go = true;
-            }
+// Reads the next non-space character (like " %c")
+bool readChar(Input* pIn, char* pChar) {
+    if (!pIn->bulk) {
+        if (pIn->pPrompt != NULL) {
+            flushOut(pIn->pPrompt);
         }
+        return scanf(" %c", pChar) == 1;
     }
-
-    for (int i = 0; i< numOrg; i++) {
-        printf("  %s: %d\n", pWeb[i].name, height[i]);
+    if (!skipSpace(pIn)) {
+        return false;
     }
+    *pChar = pIn->data[pIn->pos++];
+    return true;
 }
 
-void voreType(Org *pWeb, int numOrg) {
-    // Finds and prints producers
-    printf("  Producers:\n");
-    for (int i = 0; i < numOrg; i++) {
-        if (pWeb[i].numPrey == 0) {
-            printf("    %s\n", pWeb[i].name);
-        }
+// Collects, sorted, the indices the predators of the organism at index will have once it is
+// removed; the delta debug trace prints just these lines after an extinction
+int collectPredators(const Web* pWeb, int index, int** pIndices) {
+    const Org* pOrg = orgAtIndex(pWeb, index);
+    int* indices = (int*)malloc(sizeof(int) * (pOrg->numPred + 1));
+    for (int j = 0; j < pOrg->numPred; j++) {
+        int predIndex = indexOfSlot(pWeb, pOrg->pred[j]);
+        indices[j] = (predIndex > index) ? predIndex - 1 : predIndex;
     }
-    // Finds and prints herbivores
-    printf("  Herbivores:\n");
-    for (int i = 0; i < numOrg; i++) {
-        bool herbivore = true;
-        for (int j = 0; j < pWeb[i].numPrey; j++) {
-            if (pWeb[pWeb[i].prey[j]].numPrey != 0) {
-                herbivore = false;
-            }
-        }
-        if (herbivore && pWeb[i].numPrey > 0) {
-            printf("    %s\n", pWeb[i].name);
+    // Insertion sort: the list is as long as one predator list
+    for (int j = 1; j < pOrg->numPred; j++) {
+        int value = indices[j];
+        int k = j - 1;
+        while (k >= 0 && indices[k] > value) {
+            indices[k + 1] = indices[k];
+            k--;
         }
+        indices[k + 1] = value;
     }
-    // Finds and prints omnivores
-    printf("  Omnivores:\n");
-    for (int i = 0; i < numOrg; i++) {
-        bool producer = false;
-        bool nonProducer = false;
-        for (int j = 0; j < pWeb[i].numPrey; j++) {
-            if (pWeb[pWeb[i].prey[j]].numPrey == 0) {
-                producer = true;
-            }
-            else if (pWeb[pWeb[i].prey[j]].numPrey != 0) {
-                nonProducer = true;
-            }
-        }
-        if (producer && nonProducer) {
-            printf("    %s\n", pWeb[i].name);
-        }
+    *pIndices = indices;
+    return pOrg->numPred;
+}
+
+// Prints the debug trace for one step: the whole web, or in delta mode only the lines of
+// the organisms the step changed (given by their current indices). Batched edits are applied
+// first, so the trace shows the same web as without batching.
+void printDebugStep(OutBuf* pOut, Web* pWeb, const char* step, bool deltaMode, const int* changed, int numChanged) {
+    applyPending(pWeb);
+    outPrintf(pOut, "DEBUG MODE - %s:\n", step);
+    if (!deltaMode) {
+        printWeb(pOut, pWeb);
     }
-    // Finds and prints carnivores
-    printf("  Carnivores:\n");
-    for (int i = 0; i < numOrg; i++) {
-        bool carnivore = true;
-        for (int j = 0; j < pWeb[i].numPrey; j++) {
-            if (pWeb[pWeb[i].prey[j]].numPrey == 0) {
-                carnivore = false;
-            }
-        }
-        if (carnivore && pWeb[i].numPrey > 0) {
-            printf("    %s\n", pWeb[i].name);
+    else if (numChanged == 0) {
+        outStr(pOut, "  (no organism changed)\n");
+    }
+    else {
+        for (int k = 0; k < numChanged; k++) {
+            printOrg(pOut, pWeb, changed[k], orgAtIndex(pWeb, changed[k]));
         }
     }
-
+    outStr(pOut, "\n");
 }
 
-void displayAll(Org* pWeb, int numOrg, bool modified) {
-    if (modified) printf("UPDATED ");
-    printf("Food Web Predators & Prey:\n");
-    printWeb(pWeb,numOrg); 
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Apex Predators:\n");
-    apexPredators(pWeb, numOrg);
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Producers:\n");
-    producers(pWeb, numOrg);
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Most Flexible Eaters:\n");
-    mostFlexibleEaters(pWeb, numOrg);
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Tastiest Food:\n");
-    tastiestFood(pWeb, numOrg);
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Food Web Heights:\n");
-    heights(pWeb, numOrg);
-    printf("\n");
-
-    if (modified) printf("UPDATED ");
-    printf("Vore Types:\n");
-    voreType(pWeb, numOrg);
-    printf("\n");
+// Struct to represent the settings chosen by the command-line arguments (see setModes)
+typedef struct Settings_struct {
+    bool basicMode; // When set to true, only build the intial web, but cannot change it
+    bool debugMode; // When set to true, print out full web as it is built & modified at each step
+    bool quietMode; // When set to true, suppress printed user-input prompt messages 
+    bool bulkMode; // When set to true, load the whole input at once and parse it without scanf
+    bool deltaMode; // When set to true, debug output shows only what each step changed
+    int numThreads; // When nonzero, full displays run their sections on this many threads
+    bool cascadeMode; // When set to true, an extinction also kills consumers left without prey
+    const char* savePath; // When set, the initial web is saved to this snapshot file
+    const char* loadPath; // When set, the initial web is loaded from this snapshot file
+    bool timingMode; // When set to true, time the phases and print them with counters at exit
+    bool batchMode; // When set to true, extinctions are unlinked in one pass at the next display
+    bool weightedMode; // When set to true, relations carry weights and trophic levels are shown
+    const char* journalPath; // When set, edits are journaled to this file (and recovered from it)
+    int checkpointEvery; // Journaled edits between checkpoints, 0 for the default
+    const char* batchList; // When set, every web this list or directory names is analyzed on its own
+} Settings;
 
+// Initializes the settings with every mode off
+void initSettings(Settings* pSettings) {
+    pSettings->basicMode = false;
+    pSettings->debugMode = false;
+    pSettings->quietMode = false;
+    pSettings->bulkMode = false;
+    pSettings->deltaMode = false;
+    pSettings->numThreads = 0;
+    pSettings->cascadeMode = false;
+    pSettings->savePath = NULL;
+    pSettings->loadPath = NULL;
+    pSettings->timingMode = false;
+    pSettings->batchMode = false;
+    pSettings->weightedMode = false;
+    pSettings->journalPath = NULL;
+    pSettings->checkpointEvery = 0;
+    pSettings->batchList = NULL;
 }
 
-bool setModes(int argc, char* argv[], bool* pBasicMode, bool* pDebugMode, bool* pQuietMode) {
-    // Parse command-line arguments to set modes (basic, debug, quiet)
+bool setModes(int argc, char* argv[], Settings* pSettings) {
+    // Parse command-line arguments to set modes (basic, debug, quiet, bulk, delta, parallel, cascade,
+    // timing, batch, weighted), the snapshot files (save, load), the journal and the list of webs to batch
 //     -b or -basic or -basicmode or -b*: basicMode = TRUE, which prevents the user from making any modifications to the initial food web. That is, the user can build a food web, for which the food web analysis will be completed and displayed, and then the program terminates, without any options provided to the user to modify the food web. This mode should be turned ON for any command-line argument string begins with -b as the first two characters. 
 // -d or -debug or -debugmode or -d*: debugMode = TRUE, which prints out the full web as it is being built or modified, after each step of adding an organism to the web, adding a relationship to the web, or removing an organism from the web. This mode should be turned ON for any command-line argument string begins with -d as the first two characters.  
 // -q or -quiet or -quietmode or -q*: quietMode = TRUE, which suppresses the printed prompt messages before each user-input scan. This is particularly helpful when running the program in a non-interactive fashion by redirecting user-input to a file that contains the full set of predefined user-inputs. This mode should be turned ON for any command-line argument string begins with -q as the first two characters. 
+// -l or -load or -l*: bulkMode = TRUE, which reads the whole input up front and parses it without scanf. The input must be redirected from a file or pipe, so the prompts are suppressed as in quiet mode.
+// -e or -edits or -e*: deltaMode = TRUE, which turns on debug mode but prints only the lines of the web that each step changed instead of the whole web.
+// -p or -parallel or -p<N>: numThreads = N (or the number of online processors when no number follows), which runs the independent sections of each full display concurrently on a pool of that many threads. The output is identical to a serial run.
+// -c or -cascade or -c*: cascadeMode = TRUE, which makes each extinction also remove every consumer left with nothing to eat, transitively, and report those secondary extinctions.
+// -s <file> or -save <file>: savePath = <file>, which writes the initial food web to a binary snapshot file once it is built.
+// -i <file> or -input <file>: loadPath = <file>, which loads the initial food web from a binary snapshot file instead of reading it, so the input only holds the modifications.
+// -t or -timing or -t*: timingMode = TRUE, which times each phase of the run and each section of the displays, and prints those timings with the allocation, copy and scan counters to stderr at exit.
+// -m or -mods or -m*: batchMode = TRUE, which queues the unlinking of extinct organisms and applies every queued extinction in one pass at the next display or print. The printed messages are the same as without batching.
+// -w or -weighted or -w*: weightedMode = TRUE, which reads a positive weight after the two indices of every relation (the share of the predator's diet the prey makes up, relative to its other prey) and adds the flow-weighted trophic level of each organism to the displays.
+// -j <file> or -journal <file>: journalPath = <file>, which appends every applied modification to a binary journal and writes a checkpoint of the web every few edits. A run that reaches its end removes the journal and its checkpoints. If the journal already exists, an earlier run stopped before its end: the web is first recovered from its latest checkpoint and the edits after it, the number of modification commands that run had read is printed, and the input only holds the modification commands after those.
+// -k <N> or -checkpoint <N>: checkpointEvery = N, the number of journaled edits between checkpoints (the default is JOURNAL_CHECKPOINT_EDITS). Only valid with -j.
+// -f <list> or -files <list>: batchList = <list>, a directory of input files or a file naming one input file per line. Each file is analyzed on its own as if it were redirected to the program with -l, concurrently on a pool of -p threads (every core by default), and its output is written to <file>.out; the run ends with the number of webs analyzed per second. Not valid with -s, -j or -t.
 
     for (int i = 1; i < argc; i++) {
         if ((argv[i][0] == '-') && (argv[i][1] == 'b')) {
-            if (*pBasicMode == true) {
+            if (pSettings->basicMode == true) {
                 return false;
             }
-            *pBasicMode = true;
+            pSettings->basicMode = true;
         
         }
         else if ((argv[i][0] == '-') && (argv[i][1] == 'd')) {
-            if (*pDebugMode == true) {
+            if (pSettings->debugMode == true) {
                 return false;
             }
-            *pDebugMode = true;
+            pSettings->debugMode = true;
         }
         else if ((argv[i][0] == '-') && (argv[i][1] == 'q')) {
-            if (*pQuietMode == true) {
+            if (pSettings->quietMode == true) {
+                return false;
+            }
+            pSettings->quietMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'l')) {
+            if (pSettings->bulkMode == true) {
+                return false;
+            }
+            pSettings->bulkMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'e')) {
+            if (pSettings->deltaMode == true) {
+                return false;
+            }
+            pSettings->deltaMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'p')) {
+            if (pSettings->numThreads != 0) {
+                return false;
+            }
+            int count = 0;
+            if (!parseInt(&(argv[i][2]), &count)) {
+                count = (int)sysconf(_SC_NPROCESSORS_ONLN); // -p or -parallel: use every core
+            }
+            pSettings->numThreads = (count < 1) ? 1 : count;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'c')) {
+            if (pSettings->cascadeMode == true) {
+                return false;
+            }
+            pSettings->cascadeMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 's')) {
+            if (pSettings->savePath != NULL || i + 1 >= argc) {
+                return false;
+            }
+            pSettings->savePath = argv[++i]; // The file name is the next argument
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'i')) {
+            if (pSettings->loadPath != NULL || i + 1 >= argc) {
+                return false;
+            }
+            pSettings->loadPath = argv[++i];
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 't')) {
+            if (pSettings->timingMode == true) {
+                return false;
+            }
+            pSettings->timingMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'm')) {
+            if (pSettings->batchMode == true) {
+                return false;
+            }
+            pSettings->batchMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'w')) {
+            if (pSettings->weightedMode == true) {
+                return false;
+            }
+            pSettings->weightedMode = true;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'j')) {
+            if (pSettings->journalPath != NULL || i + 1 >= argc) {
+                return false;
+            }
+            pSettings->journalPath = argv[++i];
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'k')) {
+            if (pSettings->checkpointEvery != 0 || i + 1 >= argc || !parseInt(argv[i + 1], &(pSettings->checkpointEvery)) || pSettings->checkpointEvery < 1) {
+                return false;
+            }
+            i++;
+        }
+        else if ((argv[i][0] == '-') && (argv[i][1] == 'f')) {
+            if (pSettings->batchList != NULL || i + 1 >= argc) {
                 return false;
             }
-            *pQuietMode = true;
+            pSettings->batchList = argv[++i];
         }
         else {
             return false;
         }
     }
+    if (pSettings->checkpointEvery != 0 && pSettings->journalPath == NULL) {
+        return false; // Checkpoints belong to a journal
+    }
+    if (pSettings->batchList != NULL && (pSettings->savePath != NULL || pSettings->journalPath != NULL || pSettings->timingMode)) {
+        return false; // Every web would write the same file, and the phase timers are not shared
+    }
 
     return true; 
 
 }
 
 
-void printONorOFF(bool mode) {
+void printONorOFF(OutBuf* pOut, bool mode) {
     if (mode) {
-        printf("ON\n");
+        outStr(pOut, "ON\n");
     } else {
-        printf("OFF\n");
+        outStr(pOut, "OFF\n");
     }
 }
 
 
-int main(int argc, char* argv[]) {  
-
-    bool basicMode = false; // When set to true, only build the intial web, but cannot change it
-    bool debugMode = false; // When set to true, print out full web as it is built & modified at each step
-    bool quietMode = false; // When set to true, suppress printed user-input prompt messages 
-
-    // Goes through the command-line arguments to change basicMode, debugMode, and quietMode
-    // If valid command-line arguments are "-b", "-d", and "-q" (and can only appear once);
-    // ALSO, allow full-word command-line arguments "-basic", "-debug", and "-quiet" by simply 
-    if (!setModes(argc, argv, &basicMode, &debugMode, &quietMode)) {
-        printf("Invalid command-line argument. Terminating program...\n");
-        return 1;
-    }
-
-    // After parsing the command-line arguments the program 
-    // Displays the status of all the modes
-    // printONorOFF checks if each mode is ON or OFF
-    printf("Program Settings:\n");
-    printf("  basic mode = ");
-    printONorOFF(basicMode);
-    printf("  debug mode = ");
-    printONorOFF(debugMode);
-    printf("  quiet mode = ");
-    printONorOFF(quietMode);
-    printf("\n");
-
-    
-    
-    int numOrgs = 0; // numOrgs tracks the # of organisms in the web
-    printf("Welcome to the Food Web Application\n\n");
-    printf("--------------------------------\n\n");
-
-    Org* pWeb = NULL; // Pointer to a dynamic arr of organisms (type Org).
-    // Set to NULL because arr hasn't been allocated yet
+// Reads the organisms and then the relations of the initial web from the input, printing the
+// prompts unless quietMode is set and each step in debug (or delta) mode
+void readInitialWeb(Web* pWeb, Input* pInput, OutBuf* pOut, bool quietMode, bool debugMode, bool deltaMode) {
+    // Relation prompts ask for the weight too in weighted mode
+    const char* relationFormat = pWeb->weighted ? "<predator index> <prey index> <weight>" : "<predator index> <prey index>";
+    int predInd, preyInd;
+    double start = startPhase();
+    // Heights are only marked stale while the web is read; the first display computes them
+    // in one O(N+E) pass, where repairing them after each relation could cost O(N) apiece.
+    // The 'r' edits of the modification loop repair them incrementally again.
+    pWeb->heightsValid = false;
 
-    printf("Building the initial food web...\n");
-    
     // If quietMode is false, the program asks the user to input ogranisms names
-    if (!quietMode) printf("Enter the name for an organism in the web (or enter DONE): ");
-    char tempName[20] = "";
-    scanf("%s",tempName); 
-    if (!quietMode) printf("\n");
+    if (!quietMode) outPrintf(pOut, "Enter the name for an organism in the web (or enter DONE): ");
+    char tempName[MAX_NAME_LEN + 1] = "";
+    if (!readWord(pInput, tempName)) strcpy(tempName, "DONE");
+    if (!quietMode) outPrintf(pOut, "\n");
 
     // Loops until user inputs "Done"
     while (strcmp(tempName,"DONE") != 0) {
-        // addOrgtoWb grows the pWeb arr to add new organsim
-        addOrgToWeb(&pWeb,&numOrgs,tempName);
+        // addOrgtoWb grows the web arr to add new organsim
+        addOrgToWeb(pWeb,tempName);
         // If debugMode is True, it will print current state of the food web
         if (debugMode) {
-            printf("DEBUG MODE - added an organism:\n");
-            printWeb(pWeb,numOrgs);
-            printf("\n");
+            int newInd = pWeb->numOrg - 1;
+            printDebugStep(pOut, pWeb, "added an organism", deltaMode, &newInd, 1);
         }
-        if (!quietMode) printf("Enter the name for an organism in the web (or enter DONE): ");
-        scanf("%s",tempName); 
-        if (!quietMode) printf("\n");
+        if (!quietMode) outPrintf(pOut, "Enter the name for an organism in the web (or enter DONE): ");
+        if (!readWord(pInput, tempName)) strcpy(tempName, "DONE");
+        if (!quietMode) outPrintf(pOut, "\n");
     }
-    if (!quietMode) printf("\n");
+    if (!quietMode) outPrintf(pOut, "\n");
+    endPhase(PHASE_NAMES, start);
+    start = startPhase();
 
     // If quietMode is False, prints these
-    if (!quietMode) printf("Enter the pair of indices for a predator/prey relation.\n");
-    if (!quietMode) printf("Enter any invalid index when done (-1 2, 0 -9, 3 3, etc.).\n");
-    if (!quietMode) printf("The format is <predator index> <prey index>: ");
-        
-    int predInd, preyInd;
+    if (!quietMode) outPrintf(pOut, "Enter the pair of indices for a predator/prey relation.\n");
+    if (!quietMode) outPrintf(pOut, "Enter any invalid index when done (-1 2, 0 -9, 3 3, etc.).\n");
+    if (!quietMode) outPrintf(pOut, "The format is %s: ", relationFormat);
+    
     // Reads two ints, represneting predator and prey indices
-    scanf("%d %d",&predInd, &preyInd);
-    if (!quietMode) printf("\n");
+    if (!readIndex(pInput, pWeb, &predInd) || !readIndex(pInput, pWeb, &preyInd)) predInd = -1;
+    if (!quietMode) outPrintf(pOut, "\n");
 
     // Loops until valid predator-prey indices are enetered 
     // (Indices are in bounds and predator not preying on itself)
-    while (predInd >= 0 && preyInd >= 0 && predInd < numOrgs &&  preyInd < numOrgs && predInd != preyInd) {
-        addRelationToWeb(pWeb,numOrgs,predInd,preyInd); // Adds this relationship to the correct organism's prey array
+    while (predInd >= 0 && preyInd >= 0 && predInd < pWeb->numOrg &&  preyInd < pWeb->numOrg && predInd != preyInd) {
+        double weight = pWeb->weighted ? readWeight(pInput) : 1.0; // Only a valid pair is followed by a weight
+        bool added = addWeightedRelationToWeb(pWeb,predInd,preyInd,weight,pOut); // Adds this relationship to the correct organism's prey array
         // If debugMode is True, it will print current state of the food web
         if (debugMode) {
-            printf("DEBUG MODE - added a relation:\n");
-            printWeb(pWeb,numOrgs);
-            printf("\n");
+            printDebugStep(pOut, pWeb, "added a relation", deltaMode, &predInd, added ? 1 : 0);
         }
-        if (!quietMode) printf("Enter the pair of indices for a predator/prey relation.\n");
-        if (!quietMode) printf("Enter any invalid index when done (-1 2, 0 -9, 3 3, etc.).\n");
-        if (!quietMode) printf("The format is <predator index> <prey index>: ");
-        
-        scanf("%d %d",&predInd, &preyInd);  
-        if (!quietMode) printf("\n");
+        if (!quietMode) outPrintf(pOut, "Enter the pair of indices for a predator/prey relation.\n");
+        if (!quietMode) outPrintf(pOut, "Enter any invalid index when done (-1 2, 0 -9, 3 3, etc.).\n");
+        if (!quietMode) outPrintf(pOut, "The format is %s: ", relationFormat);
+    
+        if (!readIndex(pInput, pWeb, &predInd) || !readIndex(pInput, pWeb, &preyInd)) predInd = -1;
+        if (!quietMode) outPrintf(pOut, "\n");
+    }
+    outPrintf(pOut, "\n");
+    endPhase(PHASE_RELATIONS, start);
+}
+
+// Runs the program on one input: prints the settings, builds (or loads, or recovers) the
+// initial web, displays it and runs the modification loop, printing everything to pOut.
+// pPool runs the sections of the full displays, or is NULL. Returns the exit status: 1 if
+// the initial web could not be loaded, 0 otherwise.
+int runSession(const Settings* pSettings, Input* pInput, OutBuf* pOut, ThreadPool* pPool) {
+    bool basicMode = pSettings->basicMode;
+    bool debugMode = pSettings->debugMode;
+    bool quietMode = pSettings->quietMode;
+    bool bulkMode = pSettings->bulkMode;
+    bool deltaMode = pSettings->deltaMode;
+    int numThreads = pSettings->numThreads;
+    bool cascadeMode = pSettings->cascadeMode;
+    const char* savePath = pSettings->savePath;
+    const char* loadPath = pSettings->loadPath;
+    bool timingMode = pSettings->timingMode;
+    bool batchMode = pSettings->batchMode;
+    bool weightedMode = pSettings->weightedMode;
+    const char* journalPath = pSettings->journalPath;
+    int checkpointEvery = pSettings->checkpointEvery;
+
+    // Displays the status of all the modes
+    // printONorOFF checks if each mode is ON or OFF
+    if (deltaMode) {
+        debugMode = true; // Delta mode is a lighter form of debug mode
+    }
+    outPrintf(pOut, "Program Settings:\n");
+    outPrintf(pOut, "  basic mode = ");
+    printONorOFF(pOut, basicMode);
+    outPrintf(pOut, "  debug mode = ");
+    printONorOFF(pOut, debugMode);
+    outPrintf(pOut, "  quiet mode = ");
+    printONorOFF(pOut, quietMode);
+    if (bulkMode) {
+        outPrintf(pOut, "  bulk mode = ON\n");
+        quietMode = true; // Nobody is there to read the prompts
+    }
+    if (deltaMode) {
+        outPrintf(pOut, "  delta mode = ON\n");
+    }
+    if (cascadeMode) {
+        outPrintf(pOut, "  cascade mode = ON\n");
+    }
+    if (savePath != NULL) {
+        outPrintf(pOut, "  save snapshot = %s\n", savePath);
+    }
+    if (loadPath != NULL) {
+        outPrintf(pOut, "  load snapshot = %s\n", loadPath);
+    }
+    if (batchMode) {
+        outPrintf(pOut, "  batch mode = ON\n");
+    }
+    if (weightedMode) {
+        outPrintf(pOut, "  weighted mode = ON\n");
+    }
+    Journal journal;
+    Journal* pJournal = NULL; // Stays NULL unless edits are journaled
+    if (journalPath != NULL) {
+        initJournal(&journal, journalPath, checkpointEvery);
+        pJournal = &journal;
+        outPrintf(pOut, "  journal = %s (checkpoint every %lld edits)\n", journalPath, journal.interval);
+    }
+    if (timingMode) {
+        outPrintf(pOut, "  timing mode = ON\n");
+    }
+    if (numThreads > 0) {
+        outPrintf(pOut, "  parallel mode = ON (%d threads)\n", numThreads);
+    }
+    outPrintf(pOut, "\n");
+
+    outPrintf(pOut, "Welcome to the Food Web Application\n\n");
+    outPrintf(pOut, "--------------------------------\n\n");
+
+    Web web; // Growable food web holding a dynamic arr of organisms (type Org).
+    initWeb(&web); // Starts empty because arr hasn't been allocated yet
+    web.weighted = weightedMode;
+    // Relation prompts ask for the weight too in weighted mode
+    const char* relationFormat = weightedMode ? "<predator index> <prey index> <weight>" : "<predator index> <prey index>";
+
+    int predInd, preyInd;
+    bool loaded = true; // False if the initial web could not be loaded or recovered
+    if (pJournal != NULL && access(journalPath, F_OK) == 0) {
+        // An earlier run stopped before its end and left a journal, so carry on from the web it
+        // had reached; the input only holds the modification commands it had not read yet
+        outPrintf(pOut, "Recovering the food web from journal %s...\n", journalPath);
+        loaded = recoverJournal(pJournal, &web, pOut);
+        if (loaded) {
+            outPrintf(pOut, "Recovered the food web after %lld modification commands of the input (%lld edits replayed from the journal)\n\n",
+                journal.baseCommands + journal.numCommands, journal.numEdits);
+        }
+    }
+    else if (loadPath != NULL) {
+        // The snapshot holds the whole initial web, so the input only holds modifications
+        outPrintf(pOut, "Loading the initial food web from %s...\n", loadPath);
+        double start = startPhase();
+        loaded = loadSnapshot(&web, loadPath, pOut);
+        endPhase(PHASE_SNAPSHOT, start);
+        if (loaded) {
+            outPrintf(pOut, "\n");
+        }
+    }
+    else {
+        outPrintf(pOut, "Building the initial food web...\n");
+        readInitialWeb(&web, pInput, pOut, quietMode, debugMode, deltaMode);
+    }
+    if (loaded && pJournal != NULL) {
+        loaded = checkpointJournal(pJournal, &web, pOut); // The journal starts from the web as it is now
+    }
+    if (!loaded) {
+        outPrintf(pOut, "Terminating program...\n");
+        if (pJournal != NULL) {
+            closeJournal(pJournal);
+        }
+        freeWeb(&web);
+        return 1;
+    }
+    if (savePath != NULL) {
+        double start = startPhase();
+        if (saveSnapshot(&web, savePath, pOut)) {
+            outPrintf(pOut, "Saved the initial food web to %s\n\n", savePath);
+        }
+        endPhase(PHASE_SNAPSHOT, start);
     }
-    printf("\n");
 
-    printf("--------------------------------\n\n");
-    printf("Initial food web complete.\n");
-    printf("Displaying characteristics for the initial food web...\n");
+    outPrintf(pOut, "--------------------------------\n\n");
+    outPrintf(pOut, "Initial food web complete.\n");
+    outPrintf(pOut, "Displaying characteristics for the initial food web...\n");
     
-    displayAll(pWeb,numOrgs,false); // Prints the characteristics of the web (apex predator, producers and etc.)
+    displayAll(pOut,&web,false,pPool); // Prints the characteristics of the web (apex predator, producers and etc.)
 
     // If basicMode is false, user gets more options
     if (!basicMode) {
-        printf("--------------------------------\n\n");
-        printf("Modifying the food web...");
+        outPrintf(pOut, "--------------------------------\n\n");
+        outPrintf(pOut, "Modifying the food web...");
         char opt = '?';
+        double start = startPhase();
 
         while (opt != 'q') {
             if (!quietMode) {
-                printf("Web modification options:\n");
-                printf("   o = add a new organism (expansion)\n");
-                printf("   r = add a new predator/prey relation (supplementation)\n");
-                printf("   x = remove an organism (extinction)\n");
-                printf("   p = print the updated food web\n");
-                printf("   d = display ALL characteristics for the updated food web\n");
-                printf("   q = quit\n");
-                printf("Enter a character (o, r, x, p, d, or q): ");
-            }
-            scanf(" %c", &opt);
-            printf("\n\n");
+                outPrintf(pOut, "Web modification options:\n");
+                outPrintf(pOut, "   o = add a new organism (expansion)\n");
+                outPrintf(pOut, "   r = add a new predator/prey relation (supplementation)\n");
+                outPrintf(pOut, "   x = remove an organism (extinction)\n");
+                outPrintf(pOut, "   p = print the updated food web\n");
+                outPrintf(pOut, "   d = display ALL characteristics for the updated food web\n");
+                outPrintf(pOut, "   q = quit\n");
+                outPrintf(pOut, "Enter a character (o, r, x, p, d, or q): ");
+            }
+            if (!readChar(pInput, &opt)) opt = 'q'; // Stop at the end of the input
+            outPrintf(pOut, "\n\n");
+            bool journaled = false; // Set once the command's edit is in the journal
 
             // If user inputs 'o', they get to add a new organism
             if (opt == 'o') {
-                char newName[20];
-                if (!quietMode) printf("EXPANSION - enter the name for the new organism: ");
-                scanf("%s",newName);
-                if (!quietMode) printf("\n");
-                printf("Species Expansion: %s\n", newName);
-                addOrgToWeb(&pWeb,&numOrgs,newName);
-                printf("\n");
+                char newName[MAX_NAME_LEN + 1];
+                if (!quietMode) outPrintf(pOut, "EXPANSION - enter the name for the new organism: ");
+                if (!readWord(pInput, newName)) break;
+                if (!quietMode) outPrintf(pOut, "\n");
+                outPrintf(pOut, "Species Expansion: %s\n", newName);
+                addOrgToWeb(&web,newName);
+                if (pJournal != NULL) {
+                    journalOrg(pJournal, &web, newName, pOut);
+                    journaled = true;
+                }
+                outPrintf(pOut, "\n");
 
                 if (debugMode) {
-                    printf("DEBUG MODE - added an organism:\n");
-                    printWeb(pWeb,numOrgs);
-                    printf("\n");
+                    int newInd = web.numOrg - 1;
+                    printDebugStep(pOut, &web, "added an organism", deltaMode, &newInd, 1);
                 }
 
             } 
             // If the user input 'x', they get to remove an organims from the web
             else if (opt == 'x') {
                 int extInd;
-                if (!quietMode) printf("EXTINCTION - enter the index for the extinct organism: ");
-                scanf("%d",&extInd);
-                if (!quietMode) printf("\n");
-                if (extInd >= 0 && extInd < numOrgs) {
-                    printf("Species Extinction: %s\n", pWeb[extInd].name);
-                    removeOrgFromWeb(&pWeb,&numOrgs,extInd);
+                if (!quietMode) outPrintf(pOut, "EXTINCTION - enter the index for the extinct organism: ");
+                if (!readIndex(pInput, &web, &extInd)) extInd = -1;
+                if (!quietMode) outPrintf(pOut, "\n");
+                int* changed = NULL; // Predators whose lines the delta trace shows
+                int numChanged = 0;
+                if (extInd >= 0 && extInd < web.numOrg) {
+                    outPrintf(pOut, "Species Extinction: %s\n", orgAtIndex(&web,extInd)->name);
+                    if (cascadeMode) {
+                        // Consumers that lose all their prey die too, and so on up the web
+                        applyPending(&web); // The cascade follows the relations, so they must be current
+                        const char** lost = NULL;
+                        int numLost = cascadeExtinction(&web, extInd, &lost, deltaMode ? &changed : NULL, &numChanged);
+                        for (int k = 0; k < numLost; k++) {
+                            outPrintf(pOut, "  Secondary Extinction: %s\n", lost[k]);
+                        }
+                        outPrintf(pOut, "  Cascade size: %d secondary extinction(s)\n", numLost);
+                        free(lost);
+                    }
+                    else {
+                        if (deltaMode) {
+                            numChanged = collectPredators(&web, extInd, &changed);
+                        }
+                        if (batchMode) {
+                            deferRemoveOrg(&web,extInd,pOut); // Unlinked at the next display or print
+                        }
+                        else {
+                            removeOrgFromWeb(&web,extInd,pOut);
+                        }
+                    }
+                    if (pJournal != NULL) {
+                        journalExtinction(pJournal, &web, extInd, cascadeMode, pOut);
+                        journaled = true;
+                    }
                 } else {
-                    printf("Invalid index for species extinction\n");
+                    outPrintf(pOut, "Invalid index for species extinction\n");
                 }
-                printf("\n");
+                outPrintf(pOut, "\n");
                 
                 if (debugMode) {
-                    printf("DEBUG MODE - removed an organism:\n");
-                    printWeb(pWeb,numOrgs);
-                    printf("\n");
+                    printDebugStep(pOut, &web, "removed an organism", deltaMode, changed, numChanged);
                 }
+                free(changed);
 
             } 
             // If the user input 'r', they get to add a new predator-prey relationship
             else if (opt == 'r') {
                 int extInd;
-                if (!quietMode) printf("SUPPLEMENTATION - enter the pair of indices for the new predator/prey relation.\n");
-                if (!quietMode) printf("The format is <predator index> <prey index>: ");
-                scanf("%d %d",&predInd, &preyInd);
-                if (!quietMode) printf("\n");
+                if (!quietMode) outPrintf(pOut, "SUPPLEMENTATION - enter the pair of indices for the new predator/prey relation.\n");
+                if (!quietMode) outPrintf(pOut, "The format is %s: ", relationFormat);
+                if (!readIndex(pInput, &web, &predInd) || !readIndex(pInput, &web, &preyInd)) predInd = -1;
+                double weight = weightedMode ? readWeight(pInput) : 1.0;
+                if (!quietMode) outPrintf(pOut, "\n");
 
-                if (addRelationToWeb(pWeb,numOrgs,predInd,preyInd)) {
-                    printf("New Food Source: %s eats %s\n", pWeb[predInd].name, pWeb[preyInd].name);
+                bool added = addWeightedRelationToWeb(&web,predInd,preyInd,weight,pOut);
+                if (added) {
+                    outPrintf(pOut, "New Food Source: %s eats %s\n", orgAtIndex(&web,predInd)->name, orgAtIndex(&web,preyInd)->name);
+                    if (pJournal != NULL) {
+                        journalRelation(pJournal, &web, predInd, preyInd, weight, pOut);
+                        journaled = true;
+                    }
                 };
-                printf("\n");
+                outPrintf(pOut, "\n");
                 if (debugMode) {
-                    printf("DEBUG MODE - added a relation:\n");
-                    printWeb(pWeb,numOrgs);
-                    printf("\n");
+                    printDebugStep(pOut, &web, "added a relation", deltaMode, &predInd, added ? 1 : 0);
                 }
 
             } // If the user input 'p', it prints the new updates web
             else if (opt == 'p') {
-                printf("UPDATED Food Web Predators & Prey:\n");
-                printWeb(pWeb,numOrgs);
-                printf("\n");
+                outPrintf(pOut, "UPDATED Food Web Predators & Prey:\n");
+                applyPending(&web);
+                printWeb(pOut, &web);
+                outPrintf(pOut, "\n");
                 
             } // If the user input 'd', it displays the characteristics for the UPDATED food web
             else if (opt == 'd') {
-                printf("Displaying characteristics for the UPDATED food web...\n\n");
-                displayAll(pWeb,numOrgs,true);
+                outPrintf(pOut, "Displaying characteristics for the UPDATED food web...\n\n");
+                displayAll(pOut,&web,true,pPool);
+
+            } // If the user input 'k' (not in the menu), it ranks the species by the cascade their removal would cause
+            else if (opt == 'k') {
+                outPrintf(pOut, "Knockout sweep of the food web (secondary extinctions per removal):\n");
+                applyPending(&web);
+                knockoutSweep(pOut, &web, pPool);
+                outPrintf(pOut, "\n");
+
+            } // If the user input 'a' (not in the menu), it tells whether one organism depends on another and how closely
+            else if (opt == 'a') {
+                int consumerInd, sourceInd;
+                if (!quietMode) outPrintf(pOut, "DEPENDENCY QUERY - enter the indices of the consumer and of the organism it may depend on: ");
+                if (!readIndex(pInput, &web, &consumerInd) || !readIndex(pInput, &web, &sourceInd)) consumerInd = -1;
+                if (!quietMode) outPrintf(pOut, "\n");
+                applyPending(&web); // The index follows the relations, so they must be current
+                dependencyQuery(pOut, &web, consumerInd, sourceInd);
+                outPrintf(pOut, "\n");
 
             }
-            printf("--------------------------------");
+            if (pJournal != NULL && opt != 'q' && !journaled) {
+                journalCommand(pJournal, pOut); // Still counts toward the offset a recovery reports
+            }
+            outPrintf(pOut, "--------------------------------");
         
         }
+        endPhase(PHASE_MODIFICATIONS, start);
         
     }
 
-    freeWeb(pWeb,numOrgs); // Called to free all allocated memory associated with the web to prevent memory leaks
+    if (pJournal != NULL) {
+        finishJournal(pJournal); // The run got to its end, so nothing is left to recover
+    }
+    freeWeb(&web); // Called to free all allocated memory associated with the web to prevent memory leaks
 
     return 0;
 }
 
+// Orders paths by name for qsort
+int comparePaths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Appends a malloc'd copy of the first len characters of path to a growable path array
+void appendPath(char*** pPaths, int* pNum, int* pCap, const char* path, size_t len) {
+    if (*pNum == *pCap) {
+        *pCap = growCapacity(*pCap);
+        *pPaths = (char**)realloc(*pPaths, sizeof(char*) * (*pCap));
+    }
+    char* copy = (char*)malloc(len + 1);
+    memcpy(copy, path, len);
+    copy[len] = '\0';
+    (*pPaths)[(*pNum)++] = copy;
+}
+
+// Collects the input files of a batch into a malloc'd array. A directory gives its regular
+// files sorted by name, leaving out hidden files and the .out files of earlier batches; any
+// other file gives its lines, one path each (blank lines are skipped). Returns the number of
+// files, or -1 if the list cannot be read.
+int listBatch(const char* list, char*** pPaths) {
+    char** paths = NULL;
+    int num = 0;
+    int cap = 0;
+    DIR* dir = opendir(list);
+    if (dir != NULL) {
+        size_t listLen = strlen(list);
+        char* path = NULL;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (entry->d_name[0] == '.' || (len >= 4 && strcmp(entry->d_name + len - 4, ".out") == 0)) {
+                continue;
+            }
+            path = (char*)realloc(path, listLen + len + 2);
+            sprintf(path, "%s/%s", list, entry->d_name);
+            struct stat info;
+            if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+                appendPath(&paths, &num, &cap, path, listLen + len + 1);
+            }
+        }
+        free(path);
+        closedir(dir);
+        if (num > 1) {
+            qsort(paths, num, sizeof(char*), comparePaths);
+        }
+    }
+    else {
+        Input listInput;
+        if (!openInputFile(&listInput, list)) {
+            return -1;
+        }
+        size_t start = 0;
+        for (size_t pos = 0; pos <= listInput.len; pos++) {
+            if (pos == listInput.len || listInput.data[pos] == '\n') {
+                size_t end = pos;
+                if (end > start && listInput.data[end - 1] == '\r') {
+                    end--;
+                }
+                if (end > start) {
+                    appendPath(&paths, &num, &cap, listInput.data + start, end - start);
+                }
+                start = pos + 1;
+            }
+        }
+        closeInput(&listInput);
+    }
+    *pPaths = paths;
+    return num;
+}
+
+// Struct to represent a batch of webs analyzed concurrently, one task per input file
+typedef struct BatchJob_struct {
+    const Settings* pSettings; // Settings every session runs with
+    char** paths; // Input file of each task
+    bool* failed; // Set for each file that could not be read, written or loaded
+} BatchJob;
+
+// Runs the session of one input file, writing its output to <file>.out. Each task has its own
+// input, output buffer and web, so the tasks share nothing but the counters.
+void batchTask(void* ctx, int taskNum) {
+    BatchJob* pJob = (BatchJob*)ctx;
+    const char* path = pJob->paths[taskNum];
+    pJob->failed[taskNum] = true;
+    Input input;
+    if (!openInputFile(&input, path)) {
+        return;
+    }
+    char* outPath = (char*)malloc(strlen(path) + 5);
+    sprintf(outPath, "%s.out", path);
+    FILE* sink = fopen(outPath, "w");
+    free(outPath);
+    if (sink == NULL) {
+        closeInput(&input);
+        return;
+    }
+    OutBuf out;
+    initOut(&out, sink);
+    int status = runSession(pJob->pSettings, &input, &out, NULL);
+    closeInput(&input);
+    freeOut(&out);
+    pJob->failed[taskNum] = (fclose(sink) != 0 || status != 0);
+}
+
+// Analyzes every web of the batch list (-f) on a pool of threads, each file as a run of its
+// own with -l would, then prints the files that failed and the throughput in webs per second.
+// Returns the exit status: 1 if the list could not be read or any file failed.
+int runBatch(const Settings* pSettings, OutBuf* pOut) {
+    char** paths = NULL;
+    int numPaths = listBatch(pSettings->batchList, &paths);
+    if (numPaths < 0) {
+        outPrintf(pOut, "Cannot read the batch list %s. Terminating program...\n", pSettings->batchList);
+        return 1;
+    }
+    Settings sessionSettings = *pSettings;
+    sessionSettings.bulkMode = true; // Every file is taken in whole, with nobody to prompt
+    sessionSettings.numThreads = 0; // The pool runs whole sessions, so each one is serial
+    sessionSettings.batchList = NULL;
+    int numThreads = pSettings->numThreads;
+    if (numThreads < 1) {
+        numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    outPrintf(pOut, "Analyzing %d food webs from %s on %d threads...\n", numPaths, pSettings->batchList, numThreads);
+    flushOut(pOut);
+
+    BatchJob job;
+    job.pSettings = &sessionSettings;
+    job.paths = paths;
+    job.failed = (bool*)calloc(numPaths + 1, sizeof(bool));
+    ThreadPool pool;
+    initPool(&pool, numThreads);
+    double start = readClock();
+    runParallel(&pool, numPaths, batchTask, &job);
+    double seconds = readClock() - start;
+    freePool(&pool);
+
+    int numFailed = 0;
+    for (int k = 0; k < numPaths; k++) {
+        if (job.failed[k]) {
+            outPrintf(pOut, "  Failed: %s\n", paths[k]);
+            numFailed++;
+        }
+        free(paths[k]);
+    }
+    int numDone = numPaths - numFailed;
+    outPrintf(pOut, "Analyzed %d food webs (%d failed) in %.3f s: %.1f webs per second\n",
+        numDone, numFailed, seconds, (seconds > 0.0) ? numDone / seconds : 0.0);
+    free(job.failed);
+    free(paths);
+    return (numFailed > 0) ? 1 : 0;
+}
+
+// Tools that reuse the web code (tools/bench.c) include this file with FOODWEB_NO_MAIN defined
+#ifndef FOODWEB_NO_MAIN
+int main(int argc, char* argv[]) {  
+
+    Settings settings; // The modes, files and thread count chosen on the command line
+    initSettings(&settings);
+
+    OutBuf out; // Everything printed goes through this buffer to stdout
+    initOut(&out, stdout);
+
+    // Goes through the command-line arguments to change basicMode, debugMode, and quietMode
+    // If valid command-line arguments are "-b", "-d", and "-q" (and can only appear once);
+    // ALSO, allow full-word command-line arguments "-basic", "-debug", and "-quiet" by simply 
+    if (!setModes(argc, argv, &settings)) {
+        outStr(&out, "Invalid command-line argument. Terminating program...\n");
+        freeOut(&out);
+        return 1;
+    }
+    if (settings.batchList != NULL) {
+        int status = runBatch(&settings, &out); // Each web gets its own output file
+        freeOut(&out);
+        return status;
+    }
+    stats.timing = settings.timingMode;
+
+    ThreadPool pool;
+    ThreadPool* pPool = NULL; // Stays NULL unless parallel mode is on
+    if (settings.numThreads > 0) {
+        initPool(&pool, settings.numThreads);
+        pPool = &pool;
+    }
+    Input input;
+    openInput(&input, settings.bulkMode, settings.quietMode ? NULL : &out);
+
+    int status = runSession(&settings, &input, &out, pPool);
+
+    closeInput(&input);
+    if (pPool != NULL) {
+        freePool(pPool);
+    }
+    freeOut(&out); // Writes out whatever is still buffered
+    if (status == 0 && settings.timingMode) { // The summary goes to stderr so the normal output stays the same
+        OutBuf errOut;
+        initOut(&errOut, stderr);
+        printStats(&errOut);
+        freeOut(&errOut);
+    }
+
+    return status;
+}
+#endif
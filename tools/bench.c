@@ -0,0 +1,174 @@
+/*-------------------------------------------
+Benchmark harness for the Food Web Application
+Build: gcc -O2 -pthread tools/bench.c -o bench
+Usage: genweb ... | bench [-p <threads>] [-k <operations>] [-s <seed>] [-w]
+Builds the web read from stdin with the code of main.c, times the load, the height and
+classification passes (and with -w, for a web from genweb -w, the trophic levels), every
+displayAll section, the reachability index and the dependency queries it answers, a full
+display, and the throughput of the o / r / x edits, then prints one JSON object per run with
+the peak resident set size.
+-------------------------------------------*/
+
+#define FOODWEB_NO_MAIN
+#include "../main.c"
+#include <sys/resource.h>
+
+unsigned long long benchRng = 88172645463325252ULL; // xorshift64* state for the random edits
+
+// Returns a uniform int in [0, n) for n > 0
+int benchRandom(int n) {
+    benchRng ^= benchRng >> 12;
+    benchRng ^= benchRng << 25;
+    benchRng ^= benchRng >> 27;
+    return (int)(((benchRng * 2685821657736338717ULL) >> 33) % (unsigned long long)n);
+}
+
+// Prints a section title as a JSON key: without the colon and newline, quotes escaped
+void printKey(const char* title) {
+    putchar('"');
+    for (const char* c = title; *c != '\0' && *c != ':'; c++) {
+        if (*c == '"' || *c == '\\') {
+            putchar('\\');
+        }
+        putchar(*c);
+    }
+    putchar('"');
+}
+
+// Returns ops / seconds, or 0 when nothing was timed
+double rate(long long ops, double seconds) {
+    return (seconds > 0.0) ? ops / seconds : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    int numThreads = 0; // Thread pool size for the full display, 0 for serial
+    int numOps = 10000; // Edits of each kind to time
+    bool weighted = false; // The relations carry weights
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) {
+            numOps = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            benchRng ^= strtoull(argv[++i], NULL, 10) * 0x9E3779B97F4A7C15ULL;
+        }
+        else if (strcmp(argv[i], "-w") == 0) {
+            weighted = true;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-p threads] [-k operations] [-s seed] [-w] < web\n", argv[0]);
+            return 1;
+        }
+    }
+    if (benchRng == 0) {
+        benchRng = 1;
+    }
+    ThreadPool pool;
+    ThreadPool* pPool = NULL;
+    if (numThreads > 0) {
+        initPool(&pool, numThreads);
+        pPool = &pool;
+    }
+    FILE* sink = fopen("/dev/null", "w");
+    OutBuf out; // The printed analysis is thrown away; only producing it is timed
+    initOut(&out, sink);
+
+    // Load: the initial web is read as main reads it, with bulk input
+    double start = readClock();
+    Input input;
+    openInput(&input, true, NULL);
+    Web web;
+    initWeb(&web);
+    web.weighted = weighted;
+    readInitialWeb(&web, &input, &out, true, false, false);
+    closeInput(&input);
+    double loadTime = readClock() - start;
+    int numOrg = web.numOrg;
+    int numRel = web.numRel;
+
+    // The passes displayAll runs before printing, then each section on its own
+    start = readClock();
+    refreshHeights(&web, pPool);
+    double heightTime = readClock() - start;
+    start = readClock();
+    classifyOrgs(&web, pPool);
+    double classifyTime = readClock() - start;
+    start = readClock();
+    refreshLevels(&web, pPool);
+    double levelTime = readClock() - start;
+    start = readClock();
+    refreshReach(&web);
+    double reachTime = readClock() - start;
+    start = readClock();
+    int numDepends = 0; // Keeps the queries from being optimized away
+    for (int op = 0; op < numOps && web.numOrg >= 2; op++) {
+        int pred = benchRandom(web.numOrg);
+        int prey = (pred + 1 + benchRandom(web.numOrg - 1)) % web.numOrg;
+        numDepends += dependsOn(&web, slotOfIndex(&web, pred), slotOfIndex(&web, prey));
+    }
+    double dependsTime = readClock() - start;
+    double sectionTime[NUM_SECTIONS];
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        sectionTime[k] = 0.0;
+        if (displaySections[k].weightedOnly && !weighted) {
+            continue;
+        }
+        start = readClock();
+        displaySections[k].print(&out, &web);
+        flushOut(&out);
+        sectionTime[k] = readClock() - start;
+    }
+
+    // Edit throughput: new organisms, new relations between random organisms, extinctions
+    start = readClock();
+    char name[MAX_NAME_LEN + 1];
+    for (int op = 0; op < numOps; op++) {
+        snprintf(name, sizeof(name), "bench%d", op);
+        addOrgToWeb(&web, name);
+    }
+    double orgTime = readClock() - start;
+    start = readClock();
+    for (int op = 0; op < numOps && web.numOrg >= 2; op++) {
+        int pred = benchRandom(web.numOrg);
+        int prey = (pred + 1 + benchRandom(web.numOrg - 1)) % web.numOrg;
+        addRelationToWeb(&web, pred, prey, NULL);
+    }
+    double relTime = readClock() - start;
+    start = readClock();
+    int numRemoved = 0;
+    for (; numRemoved < numOps && web.numOrg > 0; numRemoved++) {
+        removeOrgFromWeb(&web, benchRandom(web.numOrg), NULL);
+    }
+    double removeTime = readClock() - start;
+
+    // A full display of the edited web, which recomputes what the edits invalidated
+    start = readClock();
+    displayAll(&out, &web, true, pPool);
+    flushOut(&out);
+    double displayTime = readClock() - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("{\"organisms\": %d, \"relations\": %d, \"threads\": %d, ", numOrg, numRel, numThreads);
+    printf("\"load_s\": %.6f, \"load_relations_per_s\": %.0f, ", loadTime, rate(numRel, loadTime));
+    printf("\"heights_s\": %.6f, \"classify_s\": %.6f, \"levels_s\": %.6f, \"sections_s\": {", heightTime, classifyTime, levelTime);
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        printKey(displaySections[k].title);
+        printf(": %.6f%s", sectionTime[k], (k + 1 < NUM_SECTIONS) ? ", " : "}, ");
+    }
+    printf("\"reach_index_s\": %.6f, \"depends_per_s\": %.0f, \"depends_true\": %d, ",
+        reachTime, rate(numOps, dependsTime), numDepends);
+    printf("\"add_org_per_s\": %.0f, \"add_relation_per_s\": %.0f, \"remove_per_s\": %.0f, ",
+        rate(numOps, orgTime), rate(numOps, relTime), rate(numRemoved, removeTime));
+    printf("\"display_all_s\": %.6f, \"peak_rss_kb\": %ld}\n", displayTime, usage.ru_maxrss);
+
+    freeOut(&out);
+    fclose(sink);
+    freeWeb(&web);
+    if (pPool != NULL) {
+        freePool(pPool);
+    }
+    return 0;
+}
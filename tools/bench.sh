@@ -0,0 +1,21 @@
+#!/bin/sh
+# Runs the benchmark on synthetic webs from 10^3 to 10^7 relations and prints one JSON
+# object per web. Run from the repository root.
+# Usage: tools/bench.sh [niche|cascade] [connectance] [threads] [weighted]
+MODEL=${1:-niche}
+CONNECTANCE=${2:-0.05}
+THREADS=${3:-0}
+WEIGHTS="" # -w for genweb and bench when the fourth argument is "weighted"
+[ "$4" = "weighted" ] && WEIGHTS=-w
+BIN=${TMPDIR:-/tmp}/foodweb-bench.$$
+mkdir -p "$BIN" || exit 1
+trap 'rm -rf "$BIN"' EXIT
+gcc -O2 tools/genweb.c -o "$BIN/genweb" -lm || exit 1
+gcc -O2 -pthread tools/bench.c -o "$BIN/bench" || exit 1
+
+for RELATIONS in 1000 10000 100000 1000000 10000000; do
+    # Expected relations are connectance * N^2
+    N=$(awk -v e="$RELATIONS" -v c="$CONNECTANCE" 'BEGIN { printf "%d", sqrt(e / c) + 0.5 }')
+    "$BIN/genweb" -m "$MODEL" -n "$N" -c "$CONNECTANCE" -s 1 $WEIGHTS > "$BIN/web.txt" 2> /dev/null || exit 1
+    "$BIN/bench" -p "$THREADS" -k 10000 $WEIGHTS < "$BIN/web.txt" || exit 1
+done
@@ -0,0 +1,214 @@
+/*-------------------------------------------
+Synthetic food web generator for the Food Web Application
+Build: gcc -O2 tools/genweb.c -o genweb -lm
+Usage: genweb [-m niche|cascade] [-n <organisms>] [-c <connectance>] [-s <seed>] [-x <modifications>] [-w]
+Writes a web in the input format of main.c to stdout: the organism names, DONE, one
+"<predator index> <prey index>" line per relation, and -1 -1. With -x, a script of that
+many random o/r/x modifications follows, ending with d and q. With -w every relation gets
+a random weight in [0.1, 1) for the weighted mode of main.c (-w).
+-------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Struct to represent one organism of the niche model
+typedef struct Niche_struct {
+    double value; // Niche value, uniform in [0, 1)
+    int index; // Index of the organism in the output
+} Niche;
+
+unsigned long long rngState = 88172645463325252ULL; // xorshift64* state, set from the seed
+bool weighted = false; // Write a weight after each relation
+
+// Returns the next pseudo-random 64-bit number; the same seed gives the same web everywhere
+unsigned long long nextRandom() {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+
+// Returns a uniform double in [0, 1)
+double uniform() {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Returns a uniform int in [0, n)
+int uniformInt(int n) {
+    return (int)(uniform() * n);
+}
+
+// Writes one relation, with a random weight in weighted mode
+void printRelation(int pred, int prey) {
+    if (weighted) {
+        printf("%d %d %.3f\n", pred, prey, 0.1 + 0.9 * uniform());
+    }
+    else {
+        printf("%d %d\n", pred, prey);
+    }
+}
+
+// Orders niches by value for qsort
+int compareNiches(const void* a, const void* b) {
+    double x = ((const Niche*)a)->value;
+    double y = ((const Niche*)b)->value;
+    return (x > y) - (x < y);
+}
+
+// Niche model (Williams & Martinez 2000): every organism gets a niche value n, eats every
+// organism whose niche value lies in a range of width n * Beta(1, b) centered in [r / 2, n],
+// with b chosen so the expected connectance is c. The values are sorted once and each range
+// is found by binary search, so the cost is O(N log N + E). Returns the number of relations.
+long long nicheModel(int numOrg, double connectance) {
+    Niche* niches = (Niche*)malloc(sizeof(Niche) * (numOrg + 1));
+    double* range = (double*)malloc(sizeof(double) * (numOrg + 1));
+    double* center = (double*)malloc(sizeof(double) * (numOrg + 1));
+    double beta = 1.0 / (2.0 * connectance) - 1.0;
+    for (int i = 0; i < numOrg; i++) {
+        niches[i].value = uniform();
+        niches[i].index = i;
+        range[i] = niches[i].value * (1.0 - pow(1.0 - uniform(), 1.0 / beta));
+        center[i] = range[i] / 2.0 + uniform() * (niches[i].value - range[i] / 2.0);
+    }
+    qsort(niches, numOrg, sizeof(Niche), compareNiches);
+
+    long long numRel = 0;
+    for (int i = 0; i < numOrg; i++) {
+        double low = center[i] - range[i] / 2.0;
+        double high = center[i] + range[i] / 2.0;
+        int lo = 0;
+        int hi = numOrg;
+        while (lo < hi) { // First niche value not below low
+            int mid = lo + (hi - lo) / 2;
+            if (niches[mid].value < low) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        for (int k = lo; k < numOrg && niches[k].value <= high; k++) {
+            if (niches[k].index != i) { // main.c ends the relation list at a self-loop
+                printRelation(i, niches[k].index);
+                numRel++;
+            }
+        }
+    }
+    free(niches);
+    free(range);
+    free(center);
+    return numRel;
+}
+
+// Cascade model (Cohen & Newman 1985): organisms are ranked, and each eats every organism of
+// lower rank with probability p = 2cN / (N - 1). The gap to the next relation is drawn from a
+// geometric distribution, so the cost is O(N + E) instead of one draw per pair. Ranks are
+// shuffled into indices so the input is not sorted by height. Returns the number of relations.
+long long cascadeModel(int numOrg, double connectance) {
+    int* perm = (int*)malloc(sizeof(int) * (numOrg + 1));
+    for (int i = 0; i < numOrg; i++) {
+        perm[i] = i;
+    }
+    for (int i = numOrg - 1; i > 0; i--) {
+        int j = uniformInt(i + 1);
+        int tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    double p = (numOrg > 1) ? 2.0 * connectance * numOrg / (numOrg - 1) : 0.0;
+    long long numRel = 0;
+    if (p > 0.0) {
+        double logMiss = (p < 1.0) ? log(1.0 - p) : 0.0;
+        for (int i = 1; i < numOrg; i++) {
+            for (long long j = -1; ; ) {
+                j += (p < 1.0) ? 1 + (long long)(log(1.0 - uniform()) / logMiss) : 1;
+                if (j >= i) {
+                    break;
+                }
+                printRelation(perm[i], perm[j]);
+                numRel++;
+            }
+        }
+    }
+    free(perm);
+    return numRel;
+}
+
+// Writes numMods random modifications (about 30% o, 50% r, 20% x) that keep every index
+// valid, then a full display and quit
+void modificationScript(int numOrg, int numMods) {
+    int next = numOrg; // Number for the next new organism's name
+    for (int m = 0; m < numMods; m++) {
+        double kind = uniform();
+        if (kind < 0.3 || numOrg < 2) {
+            printf("o\nsp%d\n", next++);
+            numOrg++;
+        }
+        else if (kind < 0.8) {
+            int pred = uniformInt(numOrg);
+            int prey = (pred + 1 + uniformInt(numOrg - 1)) % numOrg;
+            printf("r\n");
+            printRelation(pred, prey);
+        }
+        else {
+            printf("x\n%d\n", uniformInt(numOrg));
+            numOrg--;
+        }
+    }
+    printf("d\nq\n");
+}
+
+int main(int argc, char* argv[]) {
+    bool cascade = false; // Niche model unless -m cascade
+    int numOrg = 1000;
+    double connectance = 0.1;
+    unsigned long long seed = 1;
+    int numMods = 0;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+            cascade = (strcmp(argv[++i], "cascade") == 0);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            numOrg = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+            connectance = atof(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "-x") == 0) {
+            numMods = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0) {
+            weighted = true;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-m niche|cascade] [-n organisms] [-c connectance] [-s seed] [-x modifications] [-w]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (numOrg < 0 || connectance <= 0.0 || connectance >= 0.5 || numMods < 0) {
+        fprintf(stderr, "Need organisms >= 0, 0 < connectance < 0.5 and modifications >= 0.\n");
+        return 1;
+    }
+    rngState ^= seed * 0x9E3779B97F4A7C15ULL;
+    if (rngState == 0) {
+        rngState = 1;
+    }
+
+    for (int i = 0; i < numOrg; i++) {
+        printf("sp%d\n", i);
+    }
+    printf("DONE\n");
+    long long numRel = cascade ? cascadeModel(numOrg, connectance) : nicheModel(numOrg, connectance);
+    printf("-1 -1\n");
+    if (numMods > 0) {
+        modificationScript(numOrg, numMods);
+    }
+    fprintf(stderr, "%s model: %d organisms, %lld relations\n", cascade ? "cascade" : "niche", numOrg, numRel);
+    return 0;
+}